@@ -0,0 +1,211 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "assembler.hpp"
+#include "engine.hpp"
+
+using namespace std;
+
+#define BENCH_MIN_SECONDS 0.2 //Every case is repeated at least for this time
+#define BENCH_MIN_RUNS 3
+#define BENCH_MAX_INSTRUCTIONS 100000000 //A program that does not halt is stopped here
+
+/**
+ * @brief Structure that contains a guest program of the suite
+ * @param name The name in the report
+ * @param path The assembly file
+*/
+struct BenchProgram {
+    const char* name;
+    const char* path;
+};
+
+/**
+ * @brief Structure that contains the result of a case
+*/
+struct BenchResult {
+    Uint64 instructions, runs;
+    double seconds; //Best run
+    long rss; //Peak resident set size, in KiB
+};
+
+static const BenchProgram programs[] = {
+    {"memcpy", "bench/memcpy.asm"},
+    {"bubble_sort", "bench/bubble_sort.asm"},
+    {"sieve", "bench/sieve.asm"},
+    {"fibonacci", "bench/fibonacci.asm"},
+    {"output", "bench/output.asm"},
+    {"rsh", "example_binaries/rsh.asm"}
+};
+
+/**
+ * @brief Function to run a case in this process
+ * @param program The program
+ * @param engine The engine
+ * @param result Where to store the result
+ * @returns True if the program was assembled
+*/
+static bool runCase(const BenchProgram& program, const Engine& engine, BenchResult& result) {
+    Assembler assembler;
+    ProgramImage image;
+    if(!assembler.assembleFile(program.path, image)) {
+        for(const AssemblerDiagnostic& d : assembler.getDiagnostics())
+            cerr << program.path << ":" << d.line << ": error: " << d.message << endl;
+        return false;
+    }
+    Machine machine;
+    result.runs = 0;
+    result.seconds = 0;
+    double total = 0;
+    while(result.runs < BENCH_MIN_RUNS || total < BENCH_MIN_SECONDS) {
+        //The whole address space is available, so the programs can use any address for their data
+        machine.load(image, MEMORY_SIZE);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        result.instructions = engine.run(machine.CPU, BENCH_MAX_INSTRUCTIONS);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if(result.runs == 0 || seconds < result.seconds) result.seconds = seconds;
+        total += seconds;
+        result.runs++;
+    }
+#ifdef _WIN32
+    result.rss = 0;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    result.rss = usage.ru_maxrss;
+#ifdef __APPLE__
+    result.rss /= 1024;
+#endif
+#endif
+    return true;
+}
+
+/**
+ * @brief Function to run a case in a new process, so the peak memory is only the one of the case
+ * @param self The path of this program
+ * @param program The program index
+ * @param engine The engine index
+ * @param result Where to store the result
+ * @returns True if the case was run
+*/
+static bool spawnCase(string self, Uint8 program, Uint8 engine, BenchResult& result) {
+    string command = "\"" + self + "\" --run " + to_string(program) + " " + to_string(engine);
+#ifdef _WIN32
+    FILE* child = _popen(command.c_str(), "r");
+#else
+    FILE* child = popen(command.c_str(), "r");
+#endif
+    if(child == NULL) return false;
+    unsigned long long instructions, runs;
+    bool read = fscanf(child, "%llu %llu %lf %ld", &instructions, &runs, &result.seconds, &result.rss) == 4;
+#ifdef _WIN32
+    bool exited = _pclose(child) == 0;
+#else
+    bool exited = pclose(child) == 0;
+#endif
+    result.instructions = instructions;
+    result.runs = runs;
+    return read && exited;
+}
+
+/**
+ * @brief Function to print the usage
+ * @param name The program name
+*/
+static void usage(const char* name) {
+    cout << "Usage: " << name << " [-o results.json] [-b baseline.json] [-t tolerance%]" << endl
+        << "Run it from the project folder, every program is run on every engine" << endl;
+}
+
+int main(int argc, char* args[]) {
+    const Uint8 programCount = sizeof(programs) / sizeof(programs[0]);
+    string output = "bench/results.json", baselinePath = "bench/baseline.json";
+    double tolerance = 10;
+    for(int i = 1; i < argc; i++) {
+        string arg = args[i];
+        if(arg == "--run" && i + 2 < argc) {
+            //Child process, a single case
+            int p = atoi(args[i + 1]), e = atoi(args[i + 2]);
+            BenchResult result;
+            if(p < 0 || p >= programCount || e < 0 || e >= ENGINES || !runCase(programs[p], Engines::get(e), result))
+                return 1;
+            printf("%llu %llu %.9f %ld\n", (unsigned long long)result.instructions, (unsigned long long)result.runs,
+                result.seconds, result.rss);
+            return 0;
+        }
+        else if(arg == "-o" && i + 1 < argc) output = args[++i];
+        else if(arg == "-b" && i + 1 < argc) baselinePath = args[++i];
+        else if(arg == "-t" && i + 1 < argc) tolerance = atof(args[++i]);
+        else {
+            usage(args[0]);
+            return (arg == "-h" || arg == "--help") ? 0 : 2;
+        }
+    }
+    Value baseline;
+    ifstream baselineFile(baselinePath);
+    bool compare = baselineFile && output != baselinePath && Reader().parse(baselineFile, baseline);
+    Value root;
+    root["version"] = 1;
+    root["results"] = Value(arrayValue);
+    bool failed = false;
+    cout << left << setw(12) << "program" << setw(8) << "engine" << right << setw(14) << "instructions"
+        << setw(12) << "seconds" << setw(10) << "MIPS" << setw(10) << "RSS KiB" << "  status" << endl;
+    for(Uint8 p = 0; p < programCount; p++) {
+        for(Uint8 e = 0; e < ENGINES; e++) {
+            BenchResult result;
+            cout << left << setw(12) << programs[p].name << setw(8) << Engines::get(e).name << right;
+            if(!spawnCase(args[0], p, e, result)) {
+                cout << "  FAILED" << endl;
+                failed = true;
+                continue;
+            }
+            double mips = (result.seconds > 0) ? result.instructions / result.seconds / 1e6 : 0;
+            Value r;
+            r["program"] = programs[p].name;
+            r["engine"] = Engines::get(e).name;
+            r["instructions"] = Json::UInt64(result.instructions);
+            r["runs"] = Json::UInt64(result.runs);
+            r["seconds"] = result.seconds;
+            r["mips"] = mips;
+            r["peak_rss_kib"] = Json::Int64(result.rss);
+            root["results"].append(r);
+            cout << setw(14) << result.instructions << setw(12) << fixed << setprecision(6) << result.seconds
+                << setw(10) << setprecision(2) << mips << setw(10) << result.rss << "  ";
+            //Flagging the differences with the baseline
+            string status = (result.instructions >= BENCH_MAX_INSTRUCTIONS) ? "NO HLT" : "ok";
+            if(compare) {
+                for(const Value& b : baseline["results"]) {
+                    if(b["program"].asString() != programs[p].name || b["engine"].asString() != Engines::get(e).name) continue;
+                    double change = (b["mips"].asDouble() > 0) ? (mips / b["mips"].asDouble() - 1) * 100 : 0;
+                    if(b["instructions"].asUInt64() != result.instructions) status = "CHANGED instructions";
+                    else if(change < -tolerance) {
+                        ostringstream s;
+                        s << "REGRESSION " << setprecision(1) << change << "%";
+                        status = s.str();
+                    }
+                    else {
+                        ostringstream s;
+                        s << showpos << setprecision(1) << change << "%";
+                        status = s.str();
+                    }
+                }
+            }
+            if(status != "ok" && status[0] != '+' && status[0] != '-') failed = true;
+            cout << status << endl;
+        }
+    }
+    ofstream file(output);
+    file << root;
+    if(!file) {
+        cerr << "Cannot write " << output << endl;
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
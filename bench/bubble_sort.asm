@@ -0,0 +1,27 @@
+; Fills 128 words at 2000 in descending order, then bubble sorts them
+START:  LDWI R0 2000
+        LDWI R1 0080
+        LDWI R3 0002
+        CP R0 R2
+FILL:   STWR R1 R2
+        ADD R3 R2
+        DEC R1
+        JMPNZ FILL
+        LDWI R1 007F            ; passes
+PASS:   CP R0 R2                ; current element
+        CP R1 R6                ; comparisons left in this pass
+INNER:  LDWR R4 R2
+        CP R2 R7
+        ADD R3 R7               ; next element
+        LDWR R5 R7
+        CP R5 R8
+        SUB R4 R8               ; next - current
+        JMPNN NOSWAP
+        STWR R5 R2
+        STWR R4 R7
+NOSWAP: CP R7 R2
+        DEC R6
+        JMPNZ INNER
+        DEC R1
+        JMPNZ PASS
+        HLT
@@ -0,0 +1,21 @@
+; Recursive Fibonacci of 16 (22), the result is in R1
+START:  LDWI R0 0016
+        CALL FIB
+        HLT
+; R1 = fib(R0), R0 is kept
+FIB:    LDWI R1 0002
+        CP R0 R2
+        SUB R1 R2               ; n - 2
+        JMPNN RECURSE
+        CP R0 R1                ; fib(0) = 0, fib(1) = 1
+        RET
+RECURSE: PUSH R0
+        DEC R0
+        CALL FIB
+        PUSH R1
+        DEC R0
+        CALL FIB
+        POP R2
+        ADD R2 R1
+        POP R0
+        RET
@@ -0,0 +1,15 @@
+; Copies 8 KiB from 2000 to 4000 with word loads and stores, 8 times
+START:  LDWI R5 0008
+OUTER:  LDWI R0 2000
+        LDWI R1 4000
+        LDWI R2 1000
+        LDWI R3 0002
+COPY:   LDWR R4 R0
+        STWR R4 R1
+        ADD R3 R0
+        ADD R3 R1
+        DEC R2
+        JMPNZ COPY
+        DEC R5
+        JMPNZ OUTER
+        HLT
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "risc.hpp"
+
+using namespace std;
+
+#define MICRO_OPS 65536 //Operations in a timed batch
+#define MICRO_WARMUP 5 //Batches run before timing
+#define MICRO_REPETITIONS 51 //Timed batches, the summary is over these
+
+/**
+ * @brief Structure that contains a microbenchmark
+ * @param name The name in the report
+ * @param run The function that runs a batch of MICRO_OPS operations
+*/
+struct MicroBenchmark {
+    const char* name;
+    void (*run)();
+};
+
+static SystemBus SB;
+static CentralMemory CM(&SB);
+static InputOutputDevices IOD(&SB);
+static CentralProcessingUnit CPU(&SB, &CM, &IOD);
+static StatusRegister SR;
+static ArithmeticLogicUnit ALU(&SR);
+static volatile Uint32 sink; //Results are written here so the batches are not optimized away
+
+/**
+ * @brief Function to fill the ALU registers with different values
+*/
+static void seedRegisters() {
+    for(Uint8 r = 0; r < 16; r++) ALU.load(r, Uint16(0x9E37 * (r + 1)));
+}
+
+static void decode() {
+    Uint32 s = 0;
+    for(Uint32 i = 0; i < MICRO_OPS; i++) {
+        CPU.setIR(i);
+        CPU.decodeInstruction();
+        s += CPU.getInstName().length();
+    }
+    sink = s;
+}
+
+//The operand registers change at every operation, d in the low nibble and s in the high one
+#define ALU_BINARY(function, operation) \
+    static void function() { \
+        seedRegisters(); \
+        for(Uint32 i = 0; i < MICRO_OPS; i++) ALU.operation(i & 0xF, (i >> 4) & 0xF); \
+        sink = ALU.get(0) + SR.Z + SR.N + SR.C + SR.V; \
+    }
+#define ALU_UNARY(function, operation) \
+    static void function() { \
+        seedRegisters(); \
+        for(Uint32 i = 0; i < MICRO_OPS; i++) ALU.operation(i & 0xF); \
+        sink = ALU.get(0) + SR.Z + SR.N + SR.C + SR.V; \
+    }
+
+ALU_BINARY(aluAdd, add)
+ALU_BINARY(aluSub, sub)
+ALU_UNARY(aluNot, bNot)
+ALU_BINARY(aluAnd, bAnd)
+ALU_BINARY(aluOr, bOr)
+ALU_BINARY(aluXor, bXor)
+ALU_UNARY(aluInc, inc)
+ALU_UNARY(aluDec, dec)
+ALU_UNARY(aluLsh, lShift)
+ALU_UNARY(aluRsh, rShift)
+
+/**
+ * @brief Function to run a batch of central memory operations, the addresses cover all the memory
+ * @param control The operation on the control bus
+*/
+static void memory(ControlBus control) {
+    Uint32 s = 0;
+    SB.writeControl(control);
+    for(Uint32 i = 0; i < MICRO_OPS; i++) {
+        SB.writeAddress(i * 0x9E37);
+        SB.writeData(i);
+        CM.operate();
+        s += SB.getData();
+    }
+    sink = s;
+}
+
+static void memoryReadWord() {
+    memory(ControlBus(READ, MEMORY, WORD));
+}
+
+static void memoryReadByte() {
+    memory(ControlBus(READ, MEMORY, BYTE));
+}
+
+static void memoryWriteWord() {
+    memory(ControlBus(WRITE, MEMORY, WORD));
+}
+
+static void memoryWriteByte() {
+    memory(ControlBus(WRITE, MEMORY, BYTE));
+}
+
+static void busRoundTrip() {
+    Uint32 s = 0;
+    for(Uint32 i = 0; i < MICRO_OPS; i++) {
+        SB.writeAddress(i);
+        SB.writeData(i ^ 0x5555);
+        SB.writeControl(ControlBus(i & 1, i & 2, i & 4));
+        ControlBus control = SB.getControl();
+        s += SB.getAddress() + SB.getData() + control.R + control.M + control.W;
+    }
+    sink = s;
+}
+
+static const MicroBenchmark benchmarks[] = {
+    {"decode", decode},
+    {"alu_add", aluAdd}, {"alu_sub", aluSub}, {"alu_not", aluNot}, {"alu_and", aluAnd}, {"alu_or", aluOr},
+    {"alu_xor", aluXor}, {"alu_inc", aluInc}, {"alu_dec", aluDec}, {"alu_lsh", aluLsh}, {"alu_rsh", aluRsh},
+    {"cm_read_word", memoryReadWord}, {"cm_read_byte", memoryReadByte},
+    {"cm_write_word", memoryWriteWord}, {"cm_write_byte", memoryWriteByte},
+    {"bus_round_trip", busRoundTrip}
+};
+
+/**
+ * @brief Function to get a percentile of sorted samples
+ * @param samples The samples, sorted
+ * @param p The percentile, 0 to 100
+ * @returns The sample
+*/
+static double percentile(const vector<double>& samples, double p) {
+    return samples[size_t(p / 100 * (samples.size() - 1) + 0.5)];
+}
+
+int main(int argc, char* args[]) {
+    Uint32 repetitions = MICRO_REPETITIONS;
+    string filter;
+    for(int i = 1; i < argc; i++) {
+        string arg = args[i];
+        if(arg == "-r" && i + 1 < argc) repetitions = max(atoi(args[++i]), 1);
+        else if(arg[0] != '-') filter = arg;
+        else {
+            cout << "Usage: " << args[0] << " [-r repetitions] [name filter]" << endl;
+            return (arg == "-h" || arg == "--help") ? 0 : 2;
+        }
+    }
+    InterpreterSettings settings;
+    settings.start = 0;
+    settings.ramSize = MEMORY_SIZE;
+    CM.reset(settings.ramSize);
+    CPU.reset(settings);
+    cout << left << setw(16) << "benchmark" << right << setw(10) << "median" << setw(10) << "p10" << setw(10) << "p90"
+        << setw(10) << "min" << "  ns/op, " << repetitions << " x " << MICRO_OPS << " ops" << endl;
+    vector<double> samples(repetitions);
+    for(const MicroBenchmark& b : benchmarks) {
+        if(string(b.name).find(filter) == string::npos) continue;
+        for(Uint32 i = 0; i < MICRO_WARMUP; i++) b.run();
+        for(double& sample : samples) {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            b.run();
+            sample = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / MICRO_OPS;
+        }
+        sort(samples.begin(), samples.end());
+        cout << left << setw(16) << b.name << right << fixed << setprecision(2) << setw(10) << percentile(samples, 50)
+            << setw(10) << percentile(samples, 10) << setw(10) << percentile(samples, 90) << setw(10) << samples[0] << endl;
+    }
+    return 0;
+}
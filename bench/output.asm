@@ -0,0 +1,26 @@
+; Prints a line on the monitor 256 times
+START:  LDWI R5 0100
+LINE:   LDWI R0 TEXT
+CHAR:   LDBR R1 R0
+        JMPZ END
+        OUTB R1 0000
+        INC R0
+        JMP CHAR
+END:    DEC R5
+        JMPNZ LINE
+        HLT
+TEXT:   BYTE 48
+        BYTE 65
+        BYTE 6C
+        BYTE 6C
+        BYTE 6F
+        BYTE 2C
+        BYTE 20
+        BYTE 57
+        BYTE 6F
+        BYTE 72
+        BYTE 6C
+        BYTE 64
+        BYTE 21
+        BYTE 0D
+        BYTE 00
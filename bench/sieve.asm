@@ -0,0 +1,34 @@
+; Sieve of Eratosthenes below 2000 with a byte per number at 4000, the primes are counted in R9
+START:  LDWI R0 4000
+        LDWI R1 2000            ; limit
+        LDWI RA 0001
+        LDWI RB 0000
+        CP R0 R2
+        CP R1 R3
+CLEAR:  STBR RB R2
+        INC R2
+        DEC R3
+        JMPNZ CLEAR
+        LDWI R9 0000
+        LDWI R4 0002            ; candidate
+NEXT:   CP R4 R5
+        SUB R1 R5               ; candidate - limit
+        JMPNN DONE
+        CP R0 R2
+        ADD R4 R2
+        LDBR R6 R2
+        JMPNZ SKIP              ; already marked
+        INC R9
+        CP R2 R7                ; flag of the multiple
+        CP R4 R8                ; multiple
+        ADD R4 R8
+MARK:   CP R8 R5
+        SUB R1 R5
+        JMPNN SKIP
+        ADD R4 R7
+        STBR RA R7
+        ADD R4 R8
+        JMP MARK
+SKIP:   INC R4
+        JMP NEXT
+DONE:   HLT
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "image.hpp"
+
+using namespace std;
+
+#define ASSEMBLER_VERSION 2
+
+struct AssemblerDiagnostic;
+
+/**
+ * @brief Structure that contains an assembler error
+ * @param line The source line, starting from 1
+ * @param message The error message
+*/
+struct AssemblerDiagnostic {
+    Uint32 line;
+    string message;
+};
+
+/**
+ * @brief Class to assemble a source in a single pass, label references are patched at the end
+*/
+class Assembler {
+    public:
+        /**
+         * @brief Constructor
+        */
+        Assembler();
+        /**
+         * @brief Function to assemble a source
+         * @param source The whole source text
+         * @param image The image to fill, start is changed only if there is a START label
+         * @returns True if there were no errors
+        */
+        bool assemble(const string& source, ProgramImage& image);
+        /**
+         * @brief Function to assemble a source file
+         * @param path The file path
+         * @param image The image to fill, start is changed only if there is a START label
+         * @returns True if there were no errors
+        */
+        bool assembleFile(string path, ProgramImage& image);
+        /**
+         * @brief Function to get the errors of the last assembly
+         * @returns The errors, in source order
+        */
+        const vector<AssemblerDiagnostic>& getDiagnostics();
+    private:
+        /**
+         * @brief Structure that contains a reference to a label to be patched
+         * @param offset Where to write in the image bytes
+         * @param line The source line
+         * @param relative If it is a jump offset (1 byte) instead of an address (2 bytes)
+         * @param fallback If the name is also a valid number, used when no label has that name
+         * @param value The fallback number
+         * @param name The label name
+        */
+        struct Fixup {
+            Uint32 offset, line;
+            bool relative, fallback;
+            Uint16 value;
+            string name;
+        };
+        /**
+         * @brief Structure that contains a token, pointing in the source
+        */
+        struct Token {
+            const char* begin;
+            Uint32 length;
+        };
+        unordered_map<string, Uint16> symbols;
+        vector<Fixup> fixups;
+        vector<AssemblerDiagnostic> diagnostics;
+        vector<Uint8>* out;
+        Uint32 line;
+        /**
+         * @brief Function to assemble a line already split in tokens
+         * @param tokens The tokens
+         * @param count The number of tokens
+        */
+        void assembleLine(Token* tokens, Uint8 count);
+        /**
+         * @brief Function to add an error
+         * @param message The message
+        */
+        void error(string message);
+        /**
+         * @brief Function to parse a register, R0 to RF
+         * @param t The token
+         * @returns The register number
+        */
+        Uint8 parseRegister(Token t);
+        /**
+         * @brief Function to parse an hexadecimal number
+         * @param t The token
+         * @param digits The maximum number of digits
+         * @param n Where to store the number
+         * @returns True if the token is a number
+        */
+        bool parseNumber(Token t, Uint8 digits, Uint16 &n);
+        /**
+         * @brief Function to emit a word, little endian, or to record a reference to a label
+         * @param t The token
+        */
+        void emitWord(Token t);
+        /**
+         * @brief Function to emit a byte
+         * @param t The token
+        */
+        void emitByte(Token t);
+        /**
+         * @brief Function to emit a jump offset, a raw byte or the distance to a label
+         * @param t The token
+        */
+        void emitOffset(Token t);
+};
\ No newline at end of file
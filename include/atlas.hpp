@@ -0,0 +1,143 @@
+#pragma once
+
+#include <thread>
+
+#include "utils.hpp"
+
+using namespace std;
+
+#define ATLAS_MAGIC 0x534C5441 //"ATLS" in little endian
+#define ATLAS_VERSION 1
+#define ATLAS_WIDTH 512
+#define ATLAS_IMAGE "res/atlas.png"
+#define ATLAS_TABLE "res/atlas.bin"
+
+//Sprites, in the order of the rect table
+#define ATLAS_CURSOR 0
+#define ATLAS_ICON 1
+#define ATLAS_FONT 2
+#define ATLAS_CPU_GUI 3
+#define ATLAS_CM_GUI 4
+#define ATLAS_IOD_GUI 5
+#define ATLAS_KEY 6
+#define ATLAS_KEY_PRESSED 7
+#define ATLAS_SB_GUI 8
+#define ATLAS_PROGRESS_BAR 9
+#define ATLAS_PROGRESS_BAR_NOW 10
+#define ATLAS_PROGRESS_BAR_NEXT 11
+#define ATLAS_PROGRESS_BAR_ALL 12
+#define ATLAS_FAST 13
+#define ATLAS_PLAY 14
+#define ATLAS_NEXT 15
+#define ATLAS_PAUSE 16
+#define ATLAS_RELOAD 17
+#define ATLAS_FAST_PRESSED 18
+#define ATLAS_PLAY_PRESSED 19
+#define ATLAS_NEXT_PRESSED 20
+#define ATLAS_PAUSE_PRESSED 21
+#define ATLAS_RELOAD_PRESSED 22
+#define ATLAS_SPRITES 23
+
+struct AtlasHeader;
+struct AtlasRect;
+
+/**
+ * @brief Header of the rect table, stored in little endian
+ * @param magic Always ATLAS_MAGIC
+ * @param version Format version, ATLAS_VERSION
+ * @param sprites Number of sprite rects, ATLAS_SPRITES
+ * @param width The atlas image width
+ * @param height The atlas image height
+*/
+struct AtlasHeader {
+    Uint32 magic;
+    Uint16 version;
+    Uint16 sprites;
+    Uint16 width;
+    Uint16 height;
+};
+
+/**
+ * @brief Rect in the atlas image, the table has the sprites, then the 128 letters and the 4 cursor pointers
+*/
+struct AtlasRect {
+    Uint16 x, y, w, h;
+};
+
+/**
+ * @brief Class that packs every GUI image in a single one, so there is one decode and one texture upload
+*/
+class TextureAtlas {
+    public:
+        /**
+         * @brief Constructor
+        */
+        TextureAtlas();
+        /**
+         * @brief Destructor, waits for the worker and frees the image
+        */
+        ~TextureAtlas();
+        /**
+         * @brief Function to start loading the atlas in background,
+         * the packed one if it was built, otherwise the single images are packed now
+         * @param plogger The logger, type Logger*
+        */
+        void start(Logger* plogger);
+        /**
+         * @brief Function to wait for the background loading
+         * @returns The atlas image, NULL if it could not be loaded, type SDL_Surface*
+        */
+        SDL_Surface* wait();
+        /**
+         * @brief Function to decode the single images and pack them, in parallel
+         * @returns True if packed
+        */
+        bool pack();
+        /**
+         * @brief Function to write the atlas image and its rect table
+         * @param imagePath The image path, type string
+         * @param tablePath The rect table path, type string
+         * @returns True if written
+        */
+        bool write(string imagePath, string tablePath);
+        /**
+         * @brief Function to get the rect of a sprite
+         * @param sprite The sprite, type Uint8
+         * @returns The rect, type SDL_Rect
+        */
+        SDL_Rect getRect(Uint8 sprite);
+        /**
+         * @brief Function to get the letters rects in the atlas
+         * @returns The font, type Font
+        */
+        Font getFont();
+        /**
+         * @brief Function to get the cursor pointers rects in the atlas
+         * @returns The cursor, type Cursor
+        */
+        Cursor getCursor();
+        /**
+         * @brief Function to get the last error
+         * @returns The error, type string
+        */
+        string getError();
+    private:
+        thread worker;
+        Logger* logger;
+        SDL_Surface* surface;
+        SDL_Rect rects[ATLAS_SPRITES];
+        Font font;
+        Cursor cursor;
+        string error;
+        /**
+         * @brief Function run by the worker thread
+        */
+        void load();
+        /**
+         * @brief Function to read the packed atlas
+         * @param imagePath The image path, type string
+         * @param tablePath The rect table path, type string
+         * @returns True if read
+        */
+        bool read(string imagePath, string tablePath);
+};
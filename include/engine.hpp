@@ -0,0 +1,107 @@
+#pragma once
+
+#include <vector>
+
+#include "risc.hpp"
+#include "image.hpp"
+
+using namespace std;
+
+#define ENGINES 2 //Number of ways to run the CPU, the first one is the reference
+#define ENGINE_FASTEST (ENGINES - 1) //The one to use when only the speed matters
+
+struct Engine;
+struct Machine;
+struct Checkpoint;
+
+/**
+ * @brief Structure that contains a way to run the CPU
+ * @param name The name used on the command line and in the reports
+ * @param run The function that runs up to limit instructions, it stops early on HLT,
+ * and returns the instructions retired
+*/
+struct Engine {
+    const char* name;
+    Uint64 (*run)(CentralProcessingUnit& CPU, Uint64 limit);
+};
+
+/**
+ * @brief Structure that contains a whole machine, the parts are wired together by the constructor
+*/
+struct Machine {
+    /**
+     * @brief Constructor
+    */
+    Machine();
+    Machine(const Machine&) = delete;
+    Machine& operator=(const Machine&) = delete;
+    /**
+     * @brief Function to reset the machine and load a program image
+     * @param image The program image
+     * @param ramSize The memory size, type Uint32
+    */
+    void load(const ProgramImage& image, Uint32 ramSize);
+    /**
+     * @brief Function to copy the state of another machine, faster than loading the program again
+     * @param snapshot The machine to copy
+    */
+    void restore(const Machine& snapshot);
+    /**
+     * @brief Function to get the hash of the machine state, the visible registers, the memory and the devices,
+     * so a replay with a different output does not match
+     * @returns The hash, type Uint64
+    */
+    Uint64 getHash();
+    SystemBus SB;
+    CentralMemory CM;
+    InputOutputDevices IOD;
+    CentralProcessingUnit CPU;
+};
+
+/**
+ * @brief Structure that contains the state hash after a number of instructions
+ * @param instructions The instructions retired
+ * @param hash The machine hash
+*/
+struct Checkpoint {
+    Uint64 instructions, hash;
+};
+
+namespace Engines {
+    /**
+     * @brief Function to get an engine
+     * @param index The engine index, 0 is the reference, type Uint8
+     * @returns The engine
+    */
+    const Engine& get(Uint8 index);
+    /**
+     * @brief Function to find an engine by name
+     * @param name The engine name, type string
+     * @returns The engine, NULL if there is none with that name
+    */
+    const Engine* find(string name);
+    /**
+     * @brief Function to check if the CPU stopped, it halted or it met an invalid instruction
+     * @param CPU The CPU
+     * @returns True if stopped
+    */
+    bool stopped(CentralProcessingUnit& CPU);
+    /**
+     * @brief Function to run a loaded machine and take a checkpoint every interval instructions and at the end
+     * @param machine The machine
+     * @param engine The engine
+     * @param max The maximum number of instructions, type Uint64
+     * @param interval The instructions between two checkpoints, type Uint64
+     * @param checkpoints Where to append the checkpoints
+     * @returns The instructions retired, type Uint64
+    */
+    Uint64 run(Machine& machine, const Engine& engine, Uint64 max, Uint64 interval, vector<Checkpoint>& checkpoints);
+    /**
+     * @brief Function to find the first checkpoint that differs between two runs with the same interval,
+     * it is a binary search, so the runs are expected to stay different once they diverged
+     * @param a The first run checkpoints
+     * @param b The second run checkpoints
+     * @returns The index of the first differing checkpoint, the size of both runs if they are the same, type size_t
+    */
+    size_t firstDifference(const vector<Checkpoint>& a, const vector<Checkpoint>& b);
+}
@@ -25,6 +25,13 @@ class Entity {
          * @param w Width
         */
         Entity(Vector2f ppos, SDL_Texture* ptexture, Uint16 h, Uint16 w);
+        /**
+         * @brief Constructor
+         * @param ppos Position of the entity on the screen, type Vector2f
+         * @param ptexture The texture for the entity, type SDL_Texture*
+         * @param frame The frame in the texture, type SDL_Rect
+        */
+        Entity(Vector2f ppos, SDL_Texture* ptexture, SDL_Rect frame);
         /**
          * @brief Function to get the position of the entity
          * @return The position, type Vector2f
@@ -77,8 +84,11 @@ class Entity {
         SDL_Texture* texture;
 };
 
+#define TEXT_CAPACITY 23 //Maximum characters in a text entity, longer texts are truncated
+
 /**
- * @brief Class for a text entity
+ * @brief Class for a text entity, the characters are stored inline as glyph indices
+ * and their positions are derived from the origin when rendering
 */
 class TextEntity {
     public:
@@ -113,33 +123,67 @@ class TextEntity {
          * @brief Function to build the text entity
          * @param ptext The text to build, type string
         */
-        void buildTextEntity(string ptext);
+        void buildTextEntity(const string& ptext);
         /**
-         * @brief Function to change a character
+         * @brief Function to change a character, an index past the end appends it
          * @param indx The index to change the characer at, type Uint16
          * @param c The character to change with, type char
         */
         void changeAt(Uint16 indx, char c);
         /**
-         * @brief Function to change an entity
-         * @param indx The index to change the entity at, type Uint16
-         * @param e The entity to change with, type Entity
+         * @brief Function to write an hexadecimal number in place, the glyphs are taken from a nibble table
+         * so no string is built
+         * @param indx The index of the first digit, type Uint16
+         * @param n The number, type Uint16
+         * @param digits The number of digits, type Uint8
+        */
+        void setHex(Uint16 indx, Uint16 n, Uint8 digits);
+        /**
+         * @brief Function to write characters in place
+         * @param indx The index of the first character, type Uint16
+         * @param s The characters, type const char*
+         * @param length The number of characters, type Uint16
+        */
+        void setChars(Uint16 indx, const char* s, Uint16 length);
+        /**
+         * @brief Function to get the number of characters
+         * @return The length, type Uint8
+        */
+        Uint8 getLength();
+        /**
+         * @brief Function to get the glyph indices
+         * @return The characters, type const char*
+        */
+        const char* getGlyphs();
+        /**
+         * @brief Function to get the font atlas
+         * @return The texture, type SDL_Texture*
+        */
+        SDL_Texture* getTexture();
+        /**
+         * @brief Function to get the font
+         * @return The font pointer, type Font*
+        */
+        Font* getFont();
+        /**
+         * @brief Function to highlight the text, for values that just changed
+         * @param phighlight If highlighted, type bool
         */
-        void changeAt(Uint16 indx, Entity e);
+        void setHighlight(bool phighlight);
         /**
-         * @brief Function to get the text entity
-         * @return The entity vector pointer
+         * @brief Function to get the color the glyphs are modulated with
+         * @return The color, type SDL_Color
         */
-        vector<Entity>* getTextEntity();
-        TextEntity& operator = (string ptext);
-        TextEntity& operator += (string ptext);
-        TextEntity& operator += (Entity e);
+        SDL_Color getColor();
+        TextEntity& operator = (const string& ptext);
+        TextEntity& operator += (const string& ptext);
     private:
         Vector2f pos;
         SDL_Texture* texture;
-        vector<Entity> textEntity;
         Font* font;
-        string text;
+        Uint8 length;
+        bool highlight;
+        char glyphs[TEXT_CAPACITY];
 };
 
 /**
@@ -152,15 +196,17 @@ class Button :public Entity {
          * @param ppos Position
          * @param phitbox Hitbox of the button
          * @param ptexture Texture
+         * @param pnormal The normal frame in the texture
+         * @param ppressed The pressed frame in the texture
         */
-        Button(Vector2f ppos, HitBox2d phitbox, SDL_Texture* pnormal, SDL_Texture* ppressed);
+        Button(Vector2f ppos, HitBox2d phitbox, SDL_Texture* ptexture, SDL_Rect pnormal, SDL_Rect ppressed);
         void action(void (*func)(int));
         /**
-         * @brief Function to switch the current texture with the normal one 
+         * @brief Function to switch the current frame with the normal one
         */
         void changeNormal();
         /**
-         * @brief Function to switch the current tecture with the pressed one
+         * @brief Function to switch the current frame with the pressed one
         */
         void changePressed();
         /**
@@ -170,6 +216,5 @@ class Button :public Entity {
         HitBox2d* getHitBox();
     private:
         HitBox2d hitbox;
-        SDL_Texture* normal;
-        SDL_Texture* pressed;
+        SDL_Rect normal, pressed;
 };
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <bitset>
+
+#include "engine.hpp"
+
+using namespace std;
+
+#define GDB_REGISTERS 22 //R0 to RF, PC, IR, SR, AR, DR and SP, in the order of the CHANGED_* bits
+#define GDB_BLOCK 65536 //Instructions run between two checks for an interrupt from the debugger
+#define GDB_MAX_PACKET 4096 //Bytes of a packet, as told to the debugger
+
+/**
+ * @brief Class that lets a debugger speaking the GDB remote serial protocol control a machine,
+ * on a TCP port of the local host or on a unix socket, the GUI is not used
+*/
+class GdbStub {
+    public:
+        /**
+         * @brief Constructor
+         * @param pmachine The machine, the program has to be already loaded, type Machine*
+         * @param plogger The logger, type Logger*
+        */
+        GdbStub(Machine* pmachine, Logger* plogger);
+        /**
+         * @brief Destructor, closes the sockets
+        */
+        ~GdbStub();
+        /**
+         * @brief Function to wait for a debugger and serve it until it detaches or kills the target
+         * @param address A port number or a unix socket path, type string
+         * @returns True if a debugger was served, false if the socket could not be opened
+        */
+        bool serve(string address);
+    private:
+        Machine* machine;
+        Logger* logger;
+        int server, client;
+        string path; //Unix socket path, removed when closed
+        string input; //Bytes received and not parsed yet
+        string last; //Last packet sent, sent again if the debugger asks for it
+        bitset<MEMORY_SIZE> breakpoints;
+        Uint32 breakpointCount;
+        /**
+         * @brief Function to open the listening socket
+         * @param address A port number or a unix socket path, type string
+         * @returns True if opened
+        */
+        bool listen(string address);
+        /**
+         * @brief Function to close the sockets
+        */
+        void close();
+        /**
+         * @brief Function to get a byte from the debugger, it waits for it
+         * @param c Where to store the byte
+         * @returns False if the debugger disconnected
+        */
+        bool receiveByte(char& c);
+        /**
+         * @brief Function to receive a packet, the acknowledgments are sent and received here
+         * @param packet Where to store the packet data
+         * @returns False if the debugger disconnected
+        */
+        bool receive(string& packet);
+        /**
+         * @brief Function to send a packet
+         * @param packet The packet data, type string
+        */
+        void send(string packet);
+        /**
+         * @brief Function to check without waiting if the debugger asked to stop the target
+         * @returns True if it sent an interrupt
+        */
+        bool interrupted();
+        /**
+         * @brief Function to answer a packet
+         * @param packet The packet data
+         * @param done Set to true when the debugger detaches or kills the target
+         * @returns The answer, empty for the packets not supported, type string
+        */
+        string handle(const string& packet, bool& done);
+        /**
+         * @brief Function to run the target until it stops, a breakpoint is hit or the debugger interrupts it
+         * @param single True to run a single instruction
+         * @returns The stop reply, type string
+        */
+        string resume(bool single);
+        /**
+         * @brief Function to get why the target is stopped
+         * @returns The stop reply, type string
+        */
+        string stopReply();
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+
+using namespace std;
+
+#define HEAT_EXECUTE 0 //Instruction and operand fetches
+#define HEAT_READ 1
+#define HEAT_WRITE 2
+#define HEAT_KINDS 3
+#define HEAT_SIDE 256 //The map is a square, a row per 256 bytes page
+#define HEAT_DECAY 7 //Eighths of a counter kept every frame
+#define HEAT_MIN_LEVEL 48 //Color level of a single access, so it is visible
+
+/**
+ * @brief Class that counts the memory accesses of every cell, the counters saturate and fade every frame,
+ * it is drawn as a square of HEAT_SIDE x HEAT_SIDE pixels: writes in red, executions in green, reads in blue
+*/
+class MemoryHeatmap {
+    public:
+        /**
+         * @brief Constructor
+        */
+        MemoryHeatmap();
+        /**
+         * @brief Function to count an access, it is on the path of every memory access so it is inline
+         * @param kind HEAT_EXECUTE, HEAT_READ or HEAT_WRITE, type Uint8
+         * @param address The cell address, type Uint16
+        */
+        inline void record(Uint8 kind, Uint16 address) {
+            Uint8& c = counts[kind][address];
+            c += (c != 0xFF);
+        }
+        /**
+         * @brief Function to set every counter to 0
+        */
+        void clear();
+        /**
+         * @brief Function to fade the counters, called once per frame
+         * @returns True if a counter changed, so the map has to be drawn again
+        */
+        bool decay();
+        /**
+         * @brief Function to draw the map
+         * @param pixels Where to draw, HEAT_SIDE x HEAT_SIDE pixels in ARGB8888, type Uint32*
+        */
+        void render(Uint32* pixels);
+    private:
+        Uint8 counts[HEAT_KINDS][HEAT_SIDE * HEAT_SIDE];
+        Uint8 levels[256]; //Color level of every counter value
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+
+#include "utils.hpp"
+class CentralMemory;
+
+using namespace std;
+
+#define IMAGE_MAGIC 0x4D495352 //"RSIM" in little endian
+#define IMAGE_VERSION 1
+
+struct ImageHeader;
+struct ImageSegmentHeader;
+struct ImageSymbol;
+struct ProgramImage;
+
+/**
+ * @brief Header at the start of a binary executable image, stored in little endian
+ * @param magic Always IMAGE_MAGIC
+ * @param version Format version, IMAGE_VERSION
+ * @param segmentCount Number of segments after the header
+ * @param load Address of the first byte of the program
+ * @param start Address of the first instruction
+ * @param ramSize The memory size the program needs
+ * @param symbolCount Number of symbols after the segments
+ * @param checksum FNV-1a checksum of everything after the header
+*/
+struct ImageHeader {
+    Uint32 magic;
+    Uint16 version;
+    Uint16 segmentCount;
+    Uint16 load;
+    Uint16 start;
+    Uint32 ramSize;
+    Uint32 symbolCount;
+    Uint32 checksum;
+};
+
+/**
+ * @brief Header of a segment, followed by length raw bytes
+ * @param address Address where the segment is loaded
+ * @param length Number of bytes
+*/
+struct ImageSegmentHeader {
+    Uint16 address;
+    Uint16 reserved;
+    Uint32 length;
+};
+
+/**
+ * @brief Structure that contains a symbol, stored as address, name length and name
+ * @param name The symbol name
+ * @param address The symbol address
+*/
+struct ImageSymbol {
+    string name;
+    Uint16 address;
+};
+
+/**
+ * @brief Structure that contains a program image in memory
+ * @param load Address of the first byte
+ * @param start Address of the first instruction
+ * @param ramSize The memory size the program needs
+ * @param bytes The program bytes, a single segment starting at load
+ * @param symbols The symbol table, can be empty
+*/
+struct ProgramImage {
+    /**
+     * @brief Constructor
+    */
+    ProgramImage();
+    Uint16 load, start;
+    Uint32 ramSize;
+    vector<Uint8> bytes;
+    vector<ImageSymbol> symbols;
+};
+
+namespace ImageFile {
+    /**
+     * @brief Function to write a program image to a file
+     * @param path The file path
+     * @param image The image to write
+     * @returns True if written
+    */
+    bool write(string path, const ProgramImage& image);
+    /**
+     * @brief Function to write the program bytes as an hexadecimal text file, one byte per line
+     * @param path The file path
+     * @param image The image to write
+     * @returns True if written
+    */
+    bool writeHex(string path, const ProgramImage& image);
+    /**
+     * @brief Function to map an image file and load its segments in the central memory
+     * @param path The file path
+     * @param cm The central memory pointer
+     * @param settings The interpreter settings, start and ram size are taken from the image
+     * @param logger The logger
+     * @returns True if loaded
+    */
+    bool load(string path, CentralMemory* cm, InterpreterSettings* settings, Logger* logger);
+}
\ No newline at end of file
@@ -135,12 +135,24 @@ namespace math {
      * @return The hex string
     */
     string StatusRegisterToHexstr(StatusRegister sr);
+    /**
+     * @brief Function to write the Status Register flags in a buffer, without allocating
+     * @param sr The Status Register
+     * @param s The buffer, at least 4 chars, not terminated
+    */
+    void StatusRegisterToChars(StatusRegister sr, char* s);
     /**
      * @brief Function to get the hex string from the Control Bus
      * @param cb The Control Bus
      * @return The hex string
     */
     string ControlBusToHexstr(ControlBus cb);
+    /**
+     * @brief Function to write the Control Bus in a buffer, without allocating
+     * @param cb The Control Bus
+     * @param s The buffer, at least 3 chars, not terminated
+    */
+    void ControlBusToChars(ControlBus cb, char* s);
     /**
      * @brief Function to calculate the twos complement of a 16bit number
      * @param n The number
@@ -148,22 +160,18 @@ namespace math {
     */
     Uint16 twosComplement(Uint16 n);
     /**
-     * @brief Function to get the register from an argument
-     * @param arg The argument
-     * @returns The register
-    */
-    string argumentToRegister(string arg);
-    /**
-     * @brief Function to transform a word into little endian
-     * @param w The word
-     * @returns The little endian string
+     * @brief Function to calculate the 64bit FNV-1a hash of a buffer
+     * @param data The buffer
+     * @param length The buffer length
+     * @param h The starting hash, to chain more buffers
+     * @returns The hash
     */
-    vector<string> wordToLittleEndian(string w);
+    Uint64 hash(const void* data, size_t length, Uint64 h = 0xCBF29CE484222325);
     /**
-     * @brief Function to see if a string is contained in a string vector
-     * @param v The string vector
-     * @param s The string
-     * @returns True if found
+     * @brief Function to mix the bits of a number, the splitmix64 finalizer,
+     * close numbers give unrelated results
+     * @param x The number
+     * @returns The mixed number
     */
-    bool vectorContains(vector<string> v, string s);
+    Uint64 mix(Uint64 x);
 }
\ No newline at end of file
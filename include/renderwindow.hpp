@@ -1,6 +1,7 @@
 #pragma once
 #include <iostream>
 #include <fstream>
+#include <vector>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
@@ -31,17 +32,53 @@ class RenderWindow {
          * @return The texture, type SDL_Texture*
         */
         SDL_Texture* loadTexture(const char* filePath);
+        /**
+         * @brief Function to load a texture from an image already decoded
+         * @param surface The image, type SDL_Surface*
+         * @param name The image name for the log, type char*
+         * @return The texture, type SDL_Texture*
+        */
+        SDL_Texture* loadTexture(SDL_Surface* surface, const char* name);
+        /**
+         * @brief Function to create a texture that is written by the CPU every frame
+         * @param width The width in pixels, type int
+         * @param height The height in pixels, type int
+         * @param name The texture name for the log, type char*
+         * @return The texture in ARGB8888, type SDL_Texture*
+        */
+        SDL_Texture* createStreamingTexture(int width, int height, const char* name);
+        /**
+         * @brief Function to upload the pixels of a streaming texture
+         * @param texture The texture, type SDL_Texture*
+         * @param pixels The pixels, type void*
+         * @param pitch The bytes of a row, type int
+        */
+        void updateTexture(SDL_Texture* texture, const void* pixels, int pitch);
         /**
          * @brief Function to clear the window
         */
         void clear();
+        /**
+         * @brief Function to start the static layer, what does not change between frames is drawn once in a target texture
+         * @return True if the layer has to be drawn now, the renders go in the layer until endStaticLayer, type bool
+        */
+        bool beginStaticLayer();
+        /**
+         * @brief Function to end the static layer and copy it in the window
+        */
+        void endStaticLayer();
+        /**
+         * @brief Function to force the static layer to be drawn again
+        */
+        void invalidateStaticLayer();
         /**
          * @brief Function to render a gui
          * @param entity The gui entity to render, type Entity
         */
         void renderGui(Entity& entity);
         /**
-         * @brief Function to render a text entity
+         * @brief Function to render a text entity, the glyphs are batched and drawn all together
+         * before the next non text render or the display
          * @param textEntity The text entity to render, type TextEntity
         */
         void renderText(TextEntity& textEntity);
@@ -78,4 +115,22 @@ class RenderWindow {
         Logger* logger;
         Settings* settings;
         Uint8 scale;
+        SDL_Texture* textTexture; //The atlas of the glyphs in the batch
+        vector<SDL_Vertex> textVertices;
+        vector<int> textIndices;
+        SDL_Texture* staticLayer; //Cached static gui
+        bool staticLayerValid, staticLayerDrawing;
+        int staticLayerWidth, staticLayerHeight;
+        Uint8 staticLayerScale, staticLayerSettingsScale;
+        /**
+         * @brief Function to calculate where a frame is drawn
+         * @param pos The position, type Vector2f
+         * @param frame The frame in the texture, type SDL_Rect
+         * @param dst Where to store the destination rect, type SDL_Rect
+        */
+        void calculateDestination(Vector2f pos, SDL_Rect frame, SDL_Rect& dst);
+        /**
+         * @brief Function to draw the batched glyphs with a single geometry submission
+        */
+        void flushText();
 };
\ No newline at end of file
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "utils.hpp"
+#include "heatmap.hpp"
 struct Logger;
 struct InterpreterSettings;
+struct ProgramImage;
 
 using namespace std;
 
@@ -12,6 +14,17 @@ using namespace std;
 #define INPUTOUTPUT false
 #define WORD true
 #define BYTE false
+#define MEMORY_SIZE 0x10000 //Full 16bit address space
+#define OPEN_BUS 0x00 //Value read from cells outside the configured ram size
+#define MEMORY_LINE 16 //Bytes tracked by each change counter
+#define CHANGED_R(r) (1 << (r)) //Bits of the CPU changes mask, R0 to RF are the lowest 16
+#define CHANGED_PC (1 << 16)
+#define CHANGED_IR (1 << 17)
+#define CHANGED_SR (1 << 18)
+#define CHANGED_AR (1 << 19)
+#define CHANGED_DR (1 << 20)
+#define CHANGED_SP (1 << 21)
+#define CPU_REGISTERS 22
 
 struct ControlBus;
 struct Instruction;
@@ -215,6 +228,11 @@ class ArithmeticLogicUnit {
          * @param r The register number
         */
         Uint16 get(Uint8 r);
+        /**
+         * @brief Function to copy the registers of another ALU
+         * @param snapshot The ALU to copy
+        */
+        void restore(const ArithmeticLogicUnit& snapshot);
     private:
         Uint16 R[16]; //Registers from 0 to 15
         StatusRegister* SR; //Status register pointer
@@ -238,6 +256,11 @@ class CentralProcessingUnit{
          * @brief Function that fetches the instruction from the memory
         */
         void fetchInstruction();
+        /**
+         * @brief Function to write an instruction in the Instruction Register without fetching it
+         * @param instruction The instruction
+        */
+        void setIR(Uint16 instruction);
         /**
          * @brief Function to decodes the instruction
         */
@@ -250,6 +273,11 @@ class CentralProcessingUnit{
          * @brief Function to execute the instruction 
         */
         void executeInstruction();
+        /**
+         * @brief Function to run the phases left of the current instruction
+         * @returns The cycles run, one per phase, 0 if the CPU is halted or in error, type Uint8
+        */
+        Uint8 step();
         /**
          * @brief Function to get the Program Counter value
          * @returns The program counter value
@@ -284,7 +312,7 @@ class CentralProcessingUnit{
          * @brief Function to get the instruction name
          * @return The instriction name, type string
         */
-        string getInstName();
+        const string& getInstName();
         /**
          * @brief Function to get a register from the ALU that is private
          * @param r The registrer number
@@ -297,6 +325,39 @@ class CentralProcessingUnit{
          * @param next Variable in which store phase next
         */
         void getPhases(Uint8 &now, Uint8 &next);
+        /**
+         * @brief Function to get which registers changed since the previous call
+         * @returns The mask of CHANGED_* bits, type Uint32
+        */
+        Uint32 getChanges();
+        /**
+         * @brief Function to get the number of instructions executed since the reset
+         * @returns The instructions, type Uint64
+        */
+        Uint64 getRetired();
+        /**
+         * @brief Function to get a register by index, in the order of the CHANGED_* bits
+         * @param index R0 to RF are 0 to 15, then PC, IR, SR, AR, DR and SP, type Uint8
+         * @returns The value, SR has Z, N, C and V from bit 3 to bit 0, type Uint16
+        */
+        Uint16 getRegister(Uint8 index);
+        /**
+         * @brief Function to set a register by index, for the debugger
+         * @param index The index, like getRegister, type Uint8
+         * @param value The value, type Uint16
+        */
+        void setRegister(Uint8 index, Uint16 value);
+        /**
+         * @brief Function to get the hash of the registers a program can see, R0 to RF, PC, SP, SR and
+         * if the CPU stopped, the internal ones are left out so every engine gives the same hash
+         * @returns The hash, type Uint64
+        */
+        Uint64 getHash();
+        /**
+         * @brief Function to copy the state of another CPU, this one stays connected to its own bus and devices
+         * @param snapshot The CPU to copy
+        */
+        void restore(const CentralProcessingUnit& snapshot);
     private:
         Uint16 PC; //Program Counter
         Uint16 SP; //Stack Pointer
@@ -311,6 +372,8 @@ class CentralProcessingUnit{
         InputOutputDevices* IOD; //Input Output Devices pointer
         Uint8 phaseNow, phaseNext; //Phases 0:IF 1:ID 2:OF 3:IE
         string instName; //Instruction name, for GUI
+        Uint64 retired; //Instructions executed since the reset
+        Uint16 seen[CPU_REGISTERS]; //Register values at the last getChanges, for GUI
         /**
          * @brief Function to decode the instruction name
          * @returns The instruction name
@@ -456,20 +519,86 @@ class CentralMemory {
          * @param logger The logger, type Logger
         */
         void loadProgram(InterpreterSettings* settings, Logger* logger);
+        /**
+         * @brief Function to copy a block of bytes in the memory, bytes outside the ram size are discarded
+         * @param address The first cell address, type Uint16
+         * @param data The bytes
+         * @param length The number of bytes
+        */
+        void loadBytes(Uint16 address, const Uint8* data, Uint32 length);
+        /**
+         * @brief Function to patch a reassembled program in the memory without resetting it,
+         * only the bytes that changed between the two images are written
+         * @param previous The image that is loaded
+         * @param next The new image
+         * @param conflicts Where to store the address ranges (first, last) that the program has already modified,
+         * they are left untouched
+         * @returns The number of bytes written, type Uint32
+        */
+        Uint32 patchProgram(const ProgramImage& previous, const ProgramImage& next, vector<pair<Uint16, Uint16>>& conflicts);
         /**
          * @brief Function that reads the system bus and operate
         */
         void operate();
+        /**
+         * @brief Function to read the instruction stream, like operate with a read but counted as an execution
+        */
+        void fetch();
+        /**
+         * @brief Function to set where the accesses are counted
+         * @param pheatmap The heatmap, NULL to not count them, type MemoryHeatmap*
+        */
+        void setHeatmap(MemoryHeatmap* pheatmap);
         /**
          * @brief Function to get the value of a cell
          * @param address The cell address, type Uint16
          * @returns The cell value, type Uint8
         */
         Uint8 get(Uint16 address);
+        /**
+         * @brief Function to get the generation, it changes when the whole memory is reloaded or patched
+         * @returns The generation, type Uint32
+        */
+        Uint32 getGeneration();
+        /**
+         * @brief Function to get the change counter of the line of a cell, it changes on every write in the line
+         * @param address The cell address, type Uint16
+         * @returns The counter, type Uint32
+        */
+        Uint32 getLineVersion(Uint16 address);
+        /**
+         * @brief Function to get the hash of the memory content, it is kept up to date on every write,
+         * so two memories can be compared without reading them
+         * @returns The hash, type Uint64
+        */
+        Uint64 getHash();
+        /**
+         * @brief Function to copy the content of another CM, it is a bulk change so the generation changes,
+         * the cells outside the ram size are not copied because they always hold OPEN_BUS
+         * @param snapshot The CM to copy
+        */
+        void restore(const CentralMemory& snapshot);
     private:
-        vector<Uint8> M; //All memory bytes
+        Uint8 M[MEMORY_SIZE + 1]; //All memory bytes, the last one is a guard that mirrors M[0] so words wrap
+        Uint8 sink; //Where writes to unmapped cells end up
         Uint32 size; //Memory size
+        Uint32 lineVersions[MEMORY_SIZE / MEMORY_LINE]; //Write counters, for the memory viewer, wide enough to not wrap between two refreshes
+        Uint32 generation; //Bulk changes counter
+        Uint64 hash; //XOR of the hashes of the cells inside the ram size
         SystemBus* SB; //System Bus pointer
+        MemoryHeatmap* heatmap; //Where the accesses are counted, NULL when not shown
+        /**
+         * @brief Function to write a cell inside the ram size and update the hash
+         * @param address The cell address, type Uint32
+         * @param value The value, type Uint8
+        */
+        void set(Uint32 address, Uint8 value);
+        /**
+         * @brief Function to write a cell, writes outside the ram size are discarded (open bus)
+         * @param address The cell address, type Uint16
+         * @param value The value, type Uint8
+        */
+        void store(Uint16 address, Uint8 value);
 };
 
 class InputOutputDevices {
@@ -510,6 +639,16 @@ class InputOutputDevices {
          * @returns True if a byte was received, false otherwise
         */
         bool getReceived();
+        /**
+         * @brief Function to copy the state of another IOD
+         * @param snapshot The IOD to copy
+        */
+        void restore(const InputOutputDevices& snapshot);
+        /**
+         * @brief Function to get the hash of the monitor lines, the key and the handshake flags
+         * @returns The hash, type Uint64
+        */
+        Uint64 getHash();
     private:
         SystemBus* SB; //System Bus pointer
         Uint8 key;
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <fstream>
+#include <vector>
+
+#include "engine.hpp"
+
+using namespace std;
+
+#define SESSION_MAGIC 0x53534952 //"RISS" in little endian
+#define SESSION_VERSION 1
+#define SESSION_STOPPED 4 //Phase of a stamp taken when the CPU is halted or in error
+
+//Event types, stored in the low nibble of the first byte of an event, the phase is in the high one
+#define SESSION_INPUT 0 //A key byte sent to the IOD
+#define SESSION_NEXT 1
+#define SESSION_PLAY 2
+#define SESSION_FAST 3
+#define SESSION_PAUSE 4
+#define SESSION_RELOAD 5 //The program was loaded again and the CPU reset, with the memory after the load
+#define SESSION_PATCH 6 //The program was hot reloaded, with the memory after the patch
+#define SESSION_END 7 //With the state hash at the end of the session
+
+struct SessionEvent;
+
+/**
+ * @brief Structure that contains an event of a recorded session, stamped with where the CPU was
+ * @param instructions The instructions executed since the last reset
+ * @param phase The next phase, SESSION_STOPPED if the CPU stopped
+ * @param type The event type, SESSION_*
+ * @param key The key byte, for SESSION_INPUT
+ * @param ramSize The memory size, for SESSION_RELOAD and SESSION_PATCH
+ * @param start The start address, for SESSION_RELOAD
+ * @param memory The memory content without the trailing zeros, for SESSION_RELOAD and SESSION_PATCH
+ * @param hash The machine state hash, for SESSION_END
+*/
+struct SessionEvent {
+    /**
+     * @brief Constructor
+    */
+    SessionEvent();
+    Uint64 instructions;
+    Uint8 phase, type, key;
+    Uint32 ramSize;
+    Uint16 start;
+    vector<Uint8> memory;
+    Uint64 hash;
+};
+
+/**
+ * @brief Class that records the keys and the buttons of a GUI session in a compact binary file,
+ * every event is written when it happens so a crashed session can still be replayed up to the crash
+*/
+class SessionRecorder {
+    public:
+        /**
+         * @brief Constructor
+        */
+        SessionRecorder();
+        /**
+         * @brief Destructor, ends the recording
+        */
+        ~SessionRecorder();
+        /**
+         * @brief Function to start recording, the loaded program is the first event
+         * @param path The file path, type string
+         * @param pmachine The machine, the program has to be already loaded, type Machine*
+         * @param settings The interpreter settings of the loaded program, type InterpreterSettings
+         * @returns True if the file was opened
+        */
+        bool start(string path, Machine* pmachine, InterpreterSettings settings);
+        /**
+         * @brief Function to record an event without memory
+         * @param type The event type, type Uint8
+         * @param key The key byte, for SESSION_INPUT, type Uint8
+        */
+        void record(Uint8 type, Uint8 key = 0x0);
+        /**
+         * @brief Function to record a reload or a hot reload, with the memory after it
+         * @param type SESSION_RELOAD or SESSION_PATCH, type Uint8
+         * @param settings The interpreter settings after the reload, type InterpreterSettings
+        */
+        void recordMemory(Uint8 type, InterpreterSettings settings);
+        /**
+         * @brief Function to end the recording, the state hash is the last event
+        */
+        void stop();
+    private:
+        ofstream file;
+        Machine* machine;
+        Uint64 last; //Stamp of the previous event, the stamps are stored as differences
+        SessionEvent stamp;
+        /**
+         * @brief Function to stamp an event with the CPU position
+         * @param type The event type, type Uint8
+        */
+        void stampEvent(Uint8 type);
+        /**
+         * @brief Function to write the stamped event
+        */
+        void write();
+};
+
+namespace Session {
+    /**
+     * @brief Function to read a recorded session
+     * @param path The file path
+     * @param events Where to store the events
+     * @returns True if read, a session cut by a crash is read up to the last whole event
+    */
+    bool read(string path, vector<SessionEvent>& events);
+    /**
+     * @brief Function to dump a session as JSON
+     * @param events The events
+     * @returns The JSON, type Value
+    */
+    Value toJson(const vector<SessionEvent>& events);
+    /**
+     * @brief Function to replay a session, the CPU runs at full speed between the events
+     * @param events The events
+     * @param machine The machine, it is loaded by the first event
+     * @param engine The engine that runs between the events
+     * @returns True if the session ended and the state hash is the recorded one
+    */
+    bool replay(const vector<SessionEvent>& events, Machine& machine, const Engine& engine);
+}
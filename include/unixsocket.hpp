@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+using namespace std;
+
+namespace UnixSocket {
+    /**
+     * @brief Function to open a listening unix socket. A socket left at the path by a previous run is replaced.
+     * Any other file at the path is kept and the socket is not opened
+     * @param path The socket path
+     * @param backlog The connections waiting to be accepted
+     * @returns The socket, -1 if it cannot be opened
+    */
+    int listen(string path, int backlog);
+}
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <iostream>
 #include <fstream>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <jsoncpp/json/json.h>
 #include <jsoncpp/json/value.h>
+#include <mutex>
+#include <thread>
 #include <time.h>
 
 #include "math.hpp"
@@ -19,15 +23,110 @@ struct InterpreterSettings;
 struct ConsoleSettings;
 struct WindowSettings;
 
+#define LOG_RING_SIZE 1024 //Records waiting to be written, must be a power of 2
+#define LOG_TEXT_SIZE 96 //Longest string argument of a record
+#define LOG_BUFFER_SIZE 65536 //Bytes collected before a write
+#define LOG_IDLE_WAIT 1000 //Longest sleep of the idle writer in milliseconds, a missed wake up is late at most this much
+
+//Log levels
+#define LOG_SUCCESS 0
+#define LOG_ERROR 1
+#define LOG_WARNING 2
+#define LOG_INFO 3
+
+//Log formats, each one takes the string argument and then up to two integers
+#define LOG_TEXT 0
+#define LOG_SDL_FAILED 1
+#define LOG_SDL 2
+#define LOG_IMG_FAILED 3
+#define LOG_IMG 4
+#define LOG_WINDOW_FAILED 5
+#define LOG_WINDOW 6
+#define LOG_WINDOW_CLOSED 7
+#define LOG_ICON_FAILED 8
+#define LOG_ICON 9
+#define LOG_TEXTURE_FAILED 10
+#define LOG_TEXTURE 11
+#define LOG_FILE_MISSING 12
+#define LOG_IMAGE_TRUNCATED 13
+#define LOG_IMAGE_UNKNOWN 14
+#define LOG_IMAGE_CORRUPTED 15
+#define LOG_IMAGE_FAILED 16
+#define LOG_CACHE_LOADED 17
+#define LOG_ASSEMBLING 18
+#define LOG_ASSEMBLY_FAILED 19
+#define LOG_ASSEMBLY_WRITE_FAILED 20
+#define LOG_ASSEMBLED 21
+#define LOG_WATCH_FAILED 22
+#define LOG_HOT_RELOADED 23
+#define LOG_HOT_CONFLICT 24
+#define LOG_DROPPED 25
+#define LOG_ATLAS_MISSING 26
+#define LOG_ATLAS_FAILED 27
+#define LOG_RECORDING 28
+#define LOG_RECORD_FAILED 29
+#define LOG_GDB_LISTENING 30
+#define LOG_GDB_FAILED 31
+#define LOG_GDB_CONNECTED 32
+#define LOG_GDB_DISCONNECTED 33
+
+struct LogRecord;
+
+/**
+ * @brief Structure that contains a log message waiting to be formatted
+ * @param ticks The performance counter when it was logged, type Uint64
+ * @param args The integer arguments, type Int64[]
+ * @param format The format id, type Uint16
+ * @param level The log level, type Uint8
+ * @param text The string argument, type char[]
+*/
+struct LogRecord {
+    Uint64 ticks;
+    Int64 args[2];
+    Uint16 format;
+    Uint8 level;
+    char text[LOG_TEXT_SIZE];
+};
+
 /**
- * @brief Structure that contains strings and functions for logging
+ * @brief Structure that contains strings and functions for logging,
+ * messages are queued in a lock-free ring and written by a background thread
 */
 struct Logger {
     /**
-     * @brief Function to get a string time to log
-     * @returns The string time, type string
+     * @brief Constructor
+    */
+    Logger();
+    /**
+     * @brief Destructor, writes what is left and stops the writer
+    */
+    ~Logger();
+    /**
+     * @brief Function to start the writer thread, call it after the output and the colors are set
+    */
+    void start();
+    /**
+     * @brief Function to stop the writer thread after it has written every queued record
+    */
+    void stop();
+    /**
+     * @brief Function to queue a message, it never blocks: if the ring is full the message is dropped
+     * @param level The log level, type Uint8
+     * @param format The format id, type Uint16
+     * @param text The string argument, truncated to LOG_TEXT_SIZE, type const char*
+     * @param a The first integer argument, type Int64
+     * @param b The second integer argument, type Int64
+    */
+    void log(Uint8 level, Uint16 format, const char* text = "", Int64 a = 0, Int64 b = 0);
+    /**
+     * @brief Function to queue a message, it never blocks: if the ring is full the message is dropped
+     * @param level The log level, type Uint8
+     * @param format The format id, type Uint16
+     * @param text The string argument, truncated to LOG_TEXT_SIZE, type string
+     * @param a The first integer argument, type Int64
+     * @param b The second integer argument, type Int64
     */
-    string getStringTime();
+    void log(Uint8 level, Uint16 format, const string& text, Int64 a = 0, Int64 b = 0);
     /**
      * @brief Function to set the strings for logging
      * @param log If the game will log to file, type bool
@@ -40,6 +139,50 @@ struct Logger {
     */
     float getSecond();
     string reset, success, error, warning, info;
+    private:
+        /**
+         * @brief Structure that contains a slot of the ring,
+         * the sequence tells if it is free for the producer or ready for the writer
+        */
+        struct LogCell {
+            atomic<Uint32> sequence;
+            LogRecord record;
+        };
+        LogCell* cells;
+        atomic<Uint32> head; //Next slot to be claimed by a producer
+        Uint32 tail; //Next slot to be written, only used by the writer
+        atomic<Uint32> dropped;
+        atomic<bool> running;
+        atomic<bool> sleeping; //Set while the writer waits for a record, so the producers know they have to wake it
+        thread writer;
+        mutex wakeMutex;
+        condition_variable wake;
+        time_t startTime;
+        Uint64 startTicks, frequency;
+        string buffer; //Formatted lines not written yet, only used by the writer
+        /**
+         * @brief Function run by the writer thread
+        */
+        void write();
+        /**
+         * @brief Function to check if there is something to write
+         * @returns True if a record is ready or some were dropped
+        */
+        bool pending();
+        /**
+         * @brief Function to format and write every queued record
+         * @returns True if there was at least one record
+        */
+        bool drain();
+        /**
+         * @brief Function to append a formatted record to the buffer
+         * @param record The record, type const LogRecord&
+        */
+        void format(const LogRecord& record);
+        /**
+         * @brief Function to write and empty the buffer
+        */
+        void flush();
 };
 
 /**
@@ -72,11 +215,17 @@ struct WindowSettings {
  * @param file The file name containing the binary, type string
  * @param ramSize The fixed size of the virtual memory avaiable to the virtual system
  * @param start The address of first program code line
+ * @param hotReload If an assembly file will be reassembled and patched in memory when it changes, type bool
+ * @param clock The emulated clock in Hz, a cycle per instruction phase, 0 to run as fast as possible, type Uint32
+ * @param record The file where the session is recorded for replay, empty to not record, type string
 */
 struct InterpreterSettings {
     string file;
     Uint32 ramSize, start;
     Uint8 type;
+    bool hotReload;
+    Uint32 clock;
+    string record;
 };
 /**
  * @brief Structure to contain binary interpreter settings
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+#include "entity.hpp"
+#include "risc.hpp"
+
+using namespace std;
+
+#define VIEWER_ROWS 16
+#define VIEWER_COLUMNS 2 //Bytes per row
+#define VIEWER_FREE 0
+#define VIEWER_FOLLOW_PC 1
+#define VIEWER_FOLLOW_SP 2
+
+/**
+ * @brief Class for the memory viewer, a window of rows with address, bytes and ASCII that can be moved
+ * anywhere in the address space, only the rows whose bytes changed are formatted again
+*/
+class MemoryViewer {
+    public:
+        /**
+         * @brief Constructor
+         * @param ppos Position of the first row, type Vector2f
+         * @param ptexture The font texture, type SDL_Texture*
+         * @param pfont The font, type Font*
+        */
+        MemoryViewer(Vector2f ppos, SDL_Texture* ptexture, Font* pfont);
+        /**
+         * @brief Function to scroll, stops following
+         * @param count The number of rows, negative to go up, type Int32
+        */
+        void scroll(Int32 count);
+        /**
+         * @brief Function to type a digit of the address to jump to, the address is shifted left by a nibble
+         * @param n The digit, type Uint8
+        */
+        void typeNibble(Uint8 n);
+        /**
+         * @brief Function to set what is followed
+         * @param mode VIEWER_FREE, VIEWER_FOLLOW_PC or VIEWER_FOLLOW_SP, type Uint8
+        */
+        void setFollow(Uint8 mode);
+        /**
+         * @brief Function to get what is followed
+         * @return The mode, type Uint8
+        */
+        Uint8 getFollow();
+        /**
+         * @brief Function to update the visible rows
+         * @param CM The central memory pointer
+         * @param CPU The central processing unit pointer
+         * @param ramSize The ram size, the rows wrap around it, type Uint32
+        */
+        void update(CentralMemory* CM, CentralProcessingUnit* CPU, Uint32 ramSize);
+        /**
+         * @brief Function to get the rows to render
+         * @return The rows, type vector<TextEntity>&
+        */
+        vector<TextEntity>& getRows();
+    private:
+        Uint16 start; //Address of the first row
+        Uint8 follow;
+        vector<TextEntity> rows;
+        Uint16 rowAddresses[VIEWER_ROWS];
+        Uint32 rowVersions[VIEWER_ROWS]; //Sum of the CM line versions, rows whose lines were not written are skipped
+        Uint8 rowBytes[VIEWER_ROWS][VIEWER_COLUMNS]; //Bytes shown, a line holds several rows
+        Uint32 generation; //CM generation of the formatted rows
+        bool valid;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "assembler.hpp"
+
+using namespace std;
+
+struct ProgramUpdate;
+
+/**
+ * @brief Structure that contains the result of a background reassembly
+ * @param assembled If the source was assembled without errors
+ * @param previous The image before the change
+ * @param next The image after the change
+ * @param diagnostics The assembler errors
+*/
+struct ProgramUpdate {
+    bool assembled;
+    ProgramImage previous, next;
+    vector<AssemblerDiagnostic> diagnostics;
+};
+
+/**
+ * @brief Class that watches an assembly file with inotify and reassembles it in background when it is saved
+*/
+class ProgramWatcher {
+    public:
+        /**
+         * @brief Constructor
+        */
+        ProgramWatcher();
+        /**
+         * @brief Destructor, stops the watcher
+        */
+        ~ProgramWatcher();
+        /**
+         * @brief Function to start watching the program file
+         * @param psettings The interpreter settings
+         * @returns True if the file is being watched
+        */
+        bool start(InterpreterSettings psettings);
+        /**
+         * @brief Function to stop watching
+        */
+        void stop();
+        /**
+         * @brief Function to get the last reassembly, if there is a new one
+         * @param pupdate Where to store the update
+         * @returns True if there was a new update
+        */
+        bool poll(ProgramUpdate& pupdate);
+    private:
+        InterpreterSettings settings;
+        thread worker;
+        atomic<bool> running;
+        mutex updateMutex;
+        bool updated;
+        ProgramUpdate update;
+        ProgramImage current; //Last image assembled, only used by the worker
+        int inotifyFd, stopFd;
+        /**
+         * @brief Function run by the worker thread
+        */
+        void watch();
+        /**
+         * @brief Function to assemble the file
+         * @param image Where to store the image
+         * @param diagnostics Where to store the errors
+         * @returns True if assembled
+        */
+        bool assemble(ProgramImage& image, vector<AssemblerDiagnostic>& diagnostics);
+};
@@ -0,0 +1,284 @@
+#include <algorithm>
+
+#include "assembler.hpp"
+
+using namespace std;
+
+#define FORMAT_NONE 0 //HLT
+#define FORMAT_R 1 //PUSH Rs
+#define FORMAT_RR 2 //ADD Rs Rd
+#define FORMAT_RW 3 //LDWI Rd hhhh
+#define FORMAT_RB 4 //LDBI Rd hh
+#define FORMAT_W 5 //BR hhhh
+#define FORMAT_J 6 //JMP ff
+#define FORMAT_DATA_W 7 //WORD hhhh
+#define FORMAT_DATA_B 8 //BYTE hh
+
+/**
+ * @brief Structure that contains the encoding of a mnemonic
+ * @param opcode The high byte of the instruction
+ * @param format How the operands are encoded
+*/
+struct Mnemonic {
+    Uint8 opcode, format;
+};
+
+static const unordered_map<string, Mnemonic> mnemonics = {
+    {"LDWI", {0x10, FORMAT_RW}}, {"LDBI", {0x11, FORMAT_RB}},
+    {"LDWA", {0x20, FORMAT_RW}}, {"LDBA", {0x21, FORMAT_RW}},
+    {"STWA", {0x22, FORMAT_RW}}, {"STBA", {0x23, FORMAT_RW}},
+    {"LDWR", {0x30, FORMAT_RR}}, {"LDBR", {0x31, FORMAT_RR}},
+    {"STWR", {0x32, FORMAT_RR}}, {"STBR", {0x33, FORMAT_RR}},
+    {"CP", {0x04, FORMAT_RR}}, {"MV", {0x04, FORMAT_RR}},
+    {"PUSH", {0x08, FORMAT_R}}, {"POP", {0x09, FORMAT_R}},
+    {"SPWR", {0x0D, FORMAT_R}}, {"SPRD", {0x0E, FORMAT_R}},
+    {"ADD", {0x40, FORMAT_RR}}, {"SUB", {0x41, FORMAT_RR}}, {"NOT", {0x42, FORMAT_R}},
+    {"AND", {0x43, FORMAT_RR}}, {"OR", {0x44, FORMAT_RR}}, {"XOR", {0x45, FORMAT_RR}},
+    {"INC", {0x48, FORMAT_R}}, {"DEC", {0x49, FORMAT_R}},
+    {"LSH", {0x4A, FORMAT_R}}, {"RSH", {0x4B, FORMAT_R}},
+    {"INB", {0x81, FORMAT_RW}}, {"OUTB", {0x83, FORMAT_RW}},
+    {"TSTI", {0x84, FORMAT_W}}, {"TSTO", {0x85, FORMAT_W}},
+    {"BR", {0xC0, FORMAT_W}}, {"JMP", {0xC1, FORMAT_J}},
+    {"JMPZ", {0xC2, FORMAT_J}}, {"JMPNZ", {0xC3, FORMAT_J}},
+    {"JMPN", {0xC4, FORMAT_J}}, {"JMPNN", {0xC5, FORMAT_J}},
+    {"JMPC", {0xC6, FORMAT_J}}, {"JMPV", {0xC7, FORMAT_J}},
+    {"CALL", {0xC8, FORMAT_W}}, {"RET", {0xC9, FORMAT_NONE}}, {"HLT", {0xCF, FORMAT_NONE}},
+    {"WORD", {0x00, FORMAT_DATA_W}}, {"BYTE", {0x00, FORMAT_DATA_B}}
+};
+
+/**
+ * @brief Function to get the number of operands of a format
+ * @param format The format
+ * @returns The number of operands
+*/
+static Uint8 operandCount(Uint8 format) {
+    switch(format) {
+        case FORMAT_NONE: return 0;
+        case FORMAT_RR: case FORMAT_RW: case FORMAT_RB: return 2;
+        default: return 1;
+    }
+}
+
+/**
+ * @brief Function to get the value of an hexadecimal digit
+ * @param c The digit
+ * @returns The value, 0xFF if not a digit
+*/
+static Uint8 hexDigit(char c) {
+    if(c >= '0' && c <= '9') return c - '0';
+    if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return 0xFF;
+}
+
+Assembler::Assembler() :out(NULL), line(0) {}
+
+bool Assembler::assemble(const string& source, ProgramImage& image) {
+    symbols.clear();
+    fixups.clear();
+    diagnostics.clear();
+    image.bytes.clear();
+    image.symbols.clear();
+    image.bytes.reserve(source.length() / 4);
+    out = &image.bytes;
+    line = 0;
+    const char* p = source.c_str();
+    const char* end = p + source.length();
+    Token tokens[4];
+    while(p < end) {
+        line++;
+        Uint8 count = 0;
+        bool overflow = false;
+        //Tokenizing the line, comments start with ';'
+        while(p < end && *p != '\n') {
+            char c = *p;
+            if(c == ';') {
+                while(p < end && *p != '\n') p++;
+                break;
+            }
+            if(c == ' ' || c == '\t' || c == '\r' || c == ',') {
+                p++;
+                continue;
+            }
+            const char* begin = p;
+            while(p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != ',' && *p != ';' && *p != '\n') p++;
+            //A label definition
+            if(count == 0 && *(p - 1) == ':') {
+                string name(begin, p - begin - 1);
+                if(name.empty()) error("empty label");
+                else if(!symbols.emplace(name, out->size()).second) error("label '" + name + "' already defined");
+                else image.symbols.push_back({name, Uint16(out->size())});
+                continue;
+            }
+            if(count < 4) tokens[count++] = {begin, Uint32(p - begin)};
+            else overflow = true;
+        }
+        if(p < end) p++;
+        if(overflow) error("too many operands");
+        else if(count > 0) assembleLine(tokens, count);
+    }
+    //Patching the references to labels
+    for(const Fixup& f : fixups) {
+        unordered_map<string, Uint16>::const_iterator s = symbols.find(f.name);
+        if(s == symbols.end()) {
+            //The number was already emitted
+            if(!f.fallback) diagnostics.push_back({f.line, "undefined label '" + f.name + "'"});
+            continue;
+        }
+        Uint16 value = s->second;
+        if(f.relative) {
+            //The offset is the instruction low byte, PC points after the instruction
+            Int32 distance = Int32(value) - Int32(f.offset + 2);
+            if(distance < -128 || distance > 127)
+                diagnostics.push_back({f.line, "label '" + f.name + "' is too far for a jump"});
+            (*out)[f.offset] = Uint8(distance);
+        }
+        else {
+            (*out)[f.offset] = value & 0xFF;
+            (*out)[f.offset + 1] = value >> 8;
+        }
+    }
+    if(out->size() > 0x10000) error("program does not fit in memory");
+    unordered_map<string, Uint16>::const_iterator s = symbols.find("START");
+    if(s != symbols.end()) image.start = s->second;
+    image.ramSize = min(Uint32(out->size() + 0xF0), Uint32(0x10000));
+    image.ramSize -= image.ramSize % 2;
+    out = NULL;
+    stable_sort(diagnostics.begin(), diagnostics.end(),
+        [](const AssemblerDiagnostic& a, const AssemblerDiagnostic& b) { return a.line < b.line; });
+    return diagnostics.empty();
+}
+
+bool Assembler::assembleFile(string path, ProgramImage& image) {
+    ifstream file(path, ios::binary | ios::ate);
+    if(!file) {
+        diagnostics.clear();
+        diagnostics.push_back({0, "cannot open " + path});
+        return false;
+    }
+    string source(file.tellg(), '\0');
+    file.seekg(0);
+    file.read(&source[0], source.length());
+    return assemble(source, image);
+}
+
+const vector<AssemblerDiagnostic>& Assembler::getDiagnostics() {
+    return diagnostics;
+}
+
+void Assembler::assembleLine(Token* tokens, Uint8 count) {
+    string name(tokens[0].begin, tokens[0].length);
+    unordered_map<string, Mnemonic>::const_iterator m = mnemonics.find(name);
+    if(m == mnemonics.end()) {
+        error("unknown instruction '" + name + "'");
+        return;
+    }
+    Mnemonic mnemonic = m->second;
+    if(count - 1 != operandCount(mnemonic.format)) {
+        error(name + " expects " + to_string(operandCount(mnemonic.format)) + " operand(s)");
+        return;
+    }
+    switch(mnemonic.format) {
+        case FORMAT_NONE:
+            out->push_back(0x00);
+            out->push_back(mnemonic.opcode);
+            break;
+        case FORMAT_R:
+            out->push_back(parseRegister(tokens[1]) << 4);
+            out->push_back(mnemonic.opcode);
+            break;
+        case FORMAT_RR:
+            out->push_back((parseRegister(tokens[1]) << 4) | parseRegister(tokens[2]));
+            out->push_back(mnemonic.opcode);
+            break;
+        case FORMAT_RW:
+            out->push_back(parseRegister(tokens[1]) << 4);
+            out->push_back(mnemonic.opcode);
+            emitWord(tokens[2]);
+            break;
+        case FORMAT_RB:
+            out->push_back(parseRegister(tokens[1]) << 4);
+            out->push_back(mnemonic.opcode);
+            emitByte(tokens[2]);
+            break;
+        case FORMAT_W:
+            out->push_back(0x00);
+            out->push_back(mnemonic.opcode);
+            emitWord(tokens[1]);
+            break;
+        case FORMAT_J:
+            emitOffset(tokens[1]);
+            out->push_back(mnemonic.opcode);
+            break;
+        case FORMAT_DATA_W:
+            emitWord(tokens[1]);
+            break;
+        case FORMAT_DATA_B:
+            emitByte(tokens[1]);
+    }
+}
+
+void Assembler::error(string message) {
+    diagnostics.push_back({line, message});
+}
+
+Uint8 Assembler::parseRegister(Token t) {
+    Uint8 r = (t.length == 2) ? hexDigit(t.begin[1]) : 0xFF;
+    if((t.begin[0] != 'R' && t.begin[0] != 'r') || r > 0xF) {
+        error("expected a register, found '" + string(t.begin, t.length) + "'");
+        return 0;
+    }
+    return r;
+}
+
+bool Assembler::parseNumber(Token t, Uint8 digits, Uint16 &n) {
+    const char* c = t.begin;
+    Uint32 length = t.length;
+    if(length > 2 && c[0] == '0' && (c[1] == 'x' || c[1] == 'X')) {
+        c += 2;
+        length -= 2;
+    }
+    if(length == 0 || length > digits) return false;
+    n = 0;
+    for(Uint32 i = 0; i < length; i++) {
+        Uint8 d = hexDigit(c[i]);
+        if(d > 0xF) return false;
+        n = (n << 4) | d;
+    }
+    return true;
+}
+
+void Assembler::emitWord(Token t) {
+    Fixup f;
+    f.value = 0;
+    f.fallback = parseNumber(t, 4, f.value);
+    f.offset = out->size();
+    out->push_back(f.value & 0xFF);
+    out->push_back(f.value >> 8);
+    //Labels win over numbers, so a name that is also a number is resolved at the end too
+    f.name.assign(t.begin, t.length);
+    f.line = line;
+    f.relative = false;
+    fixups.push_back(f);
+}
+
+void Assembler::emitByte(Token t) {
+    Uint16 n;
+    if(!parseNumber(t, 2, n)) {
+        error("expected a byte, found '" + string(t.begin, t.length) + "'");
+        n = 0;
+    }
+    out->push_back(n);
+}
+
+void Assembler::emitOffset(Token t) {
+    Fixup f;
+    f.value = 0;
+    f.fallback = parseNumber(t, 2, f.value);
+    f.offset = out->size();
+    out->push_back(f.value);
+    f.name.assign(t.begin, t.length);
+    f.line = line;
+    f.relative = true;
+    fixups.push_back(f);
+}
\ No newline at end of file
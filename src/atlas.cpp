@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "atlas.hpp"
+
+using namespace std;
+
+static const char* sources[ATLAS_SPRITES] = {
+    "res/cursor.png", "res/icon.png", "res/font.png", "res/cpu_gui.png", "res/cm_gui.png", "res/iod_gui.png",
+    "res/key.png", "res/key_pressed.png", "res/system_bus_gui.png", "res/progress_bar.png",
+    "res/progress_bar_now.png", "res/progress_bar_next.png", "res/progress_bar_all.png",
+    "res/fast_button.png", "res/play_button.png", "res/next_button.png", "res/pause_button.png",
+    "res/reload_button.png", "res/fast_button_pressed.png", "res/play_button_pressed.png",
+    "res/next_button_pressed.png", "res/pause_button_pressed.png", "res/reload_button_pressed.png"
+};
+
+TextureAtlas::TextureAtlas() :logger(NULL), surface(NULL) {}
+
+TextureAtlas::~TextureAtlas() {
+    wait();
+    if(surface != NULL) SDL_FreeSurface(surface);
+}
+
+void TextureAtlas::start(Logger* plogger) {
+    logger = plogger;
+    worker = thread(&TextureAtlas::load, this);
+}
+
+SDL_Surface* TextureAtlas::wait() {
+    if(worker.joinable()) worker.join();
+    return surface;
+}
+
+bool TextureAtlas::pack() {
+    SDL_Surface* images[ATLAS_SPRITES] = {NULL};
+    //Every decoder takes the next image until there are none left
+    atomic<Uint8> next(0);
+    auto decode = [&]() {
+        for(Uint8 i = next++; i < ATLAS_SPRITES; i = next++) {
+            SDL_Surface* image = IMG_Load(sources[i]);
+            if(image == NULL) continue;
+            images[i] = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA32, 0);
+            SDL_FreeSurface(image);
+        }
+    };
+    vector<thread> decoders(min(max(thread::hardware_concurrency(), 1u), 4u) - 1);
+    for(thread& t : decoders) t = thread(decode);
+    decode();
+    for(thread& t : decoders) t.join();
+    bool decoded = true;
+    for(Uint8 i = 0; i < ATLAS_SPRITES; i++) {
+        if(images[i] == NULL) {
+            error = string("cannot decode ") + sources[i];
+            decoded = false;
+        }
+    }
+    //Shelf packing, the tallest images first so every row is as high as its first image
+    Uint8 order[ATLAS_SPRITES];
+    for(Uint8 i = 0; i < ATLAS_SPRITES; i++) order[i] = i;
+    if(decoded) stable_sort(order, order + ATLAS_SPRITES, [&](Uint8 a, Uint8 b) { return images[a]->h > images[b]->h; });
+    int x = 0, y = 0, rowHeight = 0;
+    for(Uint8 i = 0; decoded && i < ATLAS_SPRITES; i++) {
+        SDL_Surface* image = images[order[i]];
+        if(image->w > ATLAS_WIDTH) {
+            error = string(sources[order[i]]) + " is too wide";
+            decoded = false;
+            break;
+        }
+        if(x + image->w > ATLAS_WIDTH) {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+        if(rowHeight == 0) rowHeight = image->h;
+        rects[order[i]] = {x, y, image->w, image->h};
+        x += image->w;
+    }
+    if(decoded) {
+        if(surface != NULL) SDL_FreeSurface(surface);
+        surface = SDL_CreateRGBSurfaceWithFormat(0, ATLAS_WIDTH, y + rowHeight, 32, SDL_PIXELFORMAT_RGBA32);
+        if(surface == NULL) {
+            error = SDL_GetError();
+            decoded = false;
+        }
+    }
+    for(Uint8 i = 0; i < ATLAS_SPRITES; i++) {
+        if(images[i] == NULL) continue;
+        if(decoded) {
+            //Copying the alpha too instead of blending on the transparent atlas
+            SDL_SetSurfaceBlendMode(images[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(images[i], NULL, surface, &rects[i]);
+        }
+        SDL_FreeSurface(images[i]);
+    }
+    if(!decoded) return false;
+    //The font and the cursor rects are relative to their images
+    font = JsonManager::getFont();
+    for(Uint8 i = 0; i < 128; i++) {
+        font.letters[i].x += rects[ATLAS_FONT].x;
+        font.letters[i].y += rects[ATLAS_FONT].y;
+    }
+    cursor = JsonManager::getCursor();
+    for(Uint8 i = 0; i < 4; i++) {
+        cursor.pointers[i].x += rects[ATLAS_CURSOR].x;
+        cursor.pointers[i].y += rects[ATLAS_CURSOR].y;
+    }
+    return true;
+}
+
+bool TextureAtlas::write(string imagePath, string tablePath) {
+    if(surface == NULL) return false;
+    if(IMG_SavePNG(surface, imagePath.c_str()) != 0) {
+        error = SDL_GetError();
+        return false;
+    }
+    AtlasHeader header;
+    header.magic = ATLAS_MAGIC;
+    header.version = ATLAS_VERSION;
+    header.sprites = ATLAS_SPRITES;
+    header.width = surface->w;
+    header.height = surface->h;
+    vector<AtlasRect> table;
+    table.reserve(ATLAS_SPRITES + 128 + 4);
+    for(Uint8 i = 0; i < ATLAS_SPRITES; i++)
+        table.push_back({Uint16(rects[i].x), Uint16(rects[i].y), Uint16(rects[i].w), Uint16(rects[i].h)});
+    for(const SDL_Rect& r : font.letters) table.push_back({Uint16(r.x), Uint16(r.y), Uint16(r.w), Uint16(r.h)});
+    for(const SDL_Rect& r : cursor.pointers) table.push_back({Uint16(r.x), Uint16(r.y), Uint16(r.w), Uint16(r.h)});
+    ofstream file(tablePath, ios::binary);
+    if(!file) {
+        error = "cannot write " + tablePath;
+        return false;
+    }
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)table.data(), table.size() * sizeof(AtlasRect));
+    return bool(file);
+}
+
+SDL_Rect TextureAtlas::getRect(Uint8 sprite) {
+    return rects[sprite];
+}
+
+Font TextureAtlas::getFont() {
+    return font;
+}
+
+Cursor TextureAtlas::getCursor() {
+    return cursor;
+}
+
+string TextureAtlas::getError() {
+    return error;
+}
+
+void TextureAtlas::load() {
+    if(read(ATLAS_IMAGE, ATLAS_TABLE)) return;
+    //Without the packed atlas, the images are packed at every startup
+    if(logger != NULL) logger->log(LOG_INFO, LOG_ATLAS_MISSING, ATLAS_IMAGE);
+    if(!pack() && logger != NULL) logger->log(LOG_ERROR, LOG_ATLAS_FAILED, error);
+}
+
+bool TextureAtlas::read(string imagePath, string tablePath) {
+    ifstream file(tablePath, ios::binary);
+    if(!file) return false;
+    AtlasHeader header;
+    AtlasRect table[ATLAS_SPRITES + 128 + 4];
+    file.read((char*)&header, sizeof(header));
+    if(!file || header.magic != ATLAS_MAGIC || header.version != ATLAS_VERSION || header.sprites != ATLAS_SPRITES)
+        return false;
+    file.read((char*)table, sizeof(table));
+    if(!file) return false;
+    SDL_Surface* image = IMG_Load(imagePath.c_str());
+    if(image == NULL) return false;
+    if(image->w != header.width || image->h != header.height) {
+        SDL_FreeSurface(image);
+        return false;
+    }
+    surface = image;
+    AtlasRect* r = table;
+    for(Uint8 i = 0; i < ATLAS_SPRITES; i++, r++) rects[i] = {r->x, r->y, r->w, r->h};
+    for(Uint8 i = 0; i < 128; i++, r++) font.letters[i] = {r->x, r->y, r->w, r->h};
+    for(Uint8 i = 0; i < 4; i++, r++) cursor.pointers[i] = {r->x, r->y, r->w, r->h};
+    return true;
+}
@@ -0,0 +1,112 @@
+#include "engine.hpp"
+
+using namespace std;
+
+/**
+ * @brief Function to run a phase at a time, like the next button, it is the reference
+ * @param CPU The CPU
+ * @param limit The maximum number of instructions
+ * @returns The instructions retired
+*/
+static Uint64 runPhases(CentralProcessingUnit& CPU, Uint64 limit) {
+    Uint64 instructions = 0;
+    Uint8 now, next;
+    while(instructions < limit) {
+        CPU.getPhases(now, next);
+        switch(next) {
+            case 0: CPU.fetchInstruction(); break;
+            case 1: CPU.decodeInstruction(); break;
+            case 2: CPU.fetchOperand(); break;
+            case 3: CPU.executeInstruction(); instructions++; break;
+            default: return instructions;
+        }
+    }
+    return instructions;
+}
+
+/**
+ * @brief Function to run a whole instruction at a time, like the fast button
+ * @param CPU The CPU
+ * @param limit The maximum number of instructions
+ * @returns The instructions retired
+*/
+static Uint64 runStep(CentralProcessingUnit& CPU, Uint64 limit) {
+    Uint64 instructions = 0;
+    while(instructions < limit && CPU.step() > 0) instructions++;
+    //An instruction rejected by the decoder ran its first phases but it was not retired
+    Uint8 now, next;
+    CPU.getPhases(now, next);
+    if(instructions > 0 && now < 3 && next > 3) instructions--;
+    return instructions;
+}
+
+static const Engine engines[ENGINES] = {
+    {"phases", runPhases},
+    {"step", runStep}
+};
+
+Machine::Machine() :CM(&SB), IOD(&SB), CPU(&SB, &CM, &IOD) {}
+
+void Machine::load(const ProgramImage& image, Uint32 ramSize) {
+    InterpreterSettings settings;
+    settings.start = image.start;
+    settings.ramSize = ramSize;
+    SB = SystemBus();
+    CM.reset(ramSize);
+    CM.loadBytes(image.load, image.bytes.data(), image.bytes.size());
+    IOD.reset();
+    CPU.reset(settings);
+}
+
+void Machine::restore(const Machine& snapshot) {
+    SB = snapshot.SB;
+    CM.restore(snapshot.CM);
+    IOD.restore(snapshot.IOD);
+    CPU.restore(snapshot.CPU);
+}
+
+Uint64 Machine::getHash() {
+    Uint64 parts[2] = {CM.getHash(), IOD.getHash()};
+    return math::hash(parts, sizeof(parts), CPU.getHash());
+}
+
+const Engine& Engines::get(Uint8 index) {
+    return engines[index];
+}
+
+const Engine* Engines::find(string name) {
+    for(const Engine& e : engines)
+        if(name == e.name) return &e;
+    return NULL;
+}
+
+bool Engines::stopped(CentralProcessingUnit& CPU) {
+    Uint8 now, next;
+    CPU.getPhases(now, next);
+    return next > 3;
+}
+
+Uint64 Engines::run(Machine& machine, const Engine& engine, Uint64 max, Uint64 interval, vector<Checkpoint>& checkpoints) {
+    Uint64 instructions = 0;
+    while(instructions < max) {
+        Uint64 block = min(interval, max - instructions);
+        Uint64 retired = engine.run(machine.CPU, block);
+        instructions += retired;
+        if(retired < block) break;
+        checkpoints.push_back({instructions, machine.getHash()});
+    }
+    if(checkpoints.empty() || checkpoints.back().instructions != instructions)
+        checkpoints.push_back({instructions, machine.getHash()});
+    return instructions;
+}
+
+size_t Engines::firstDifference(const vector<Checkpoint>& a, const vector<Checkpoint>& b) {
+    size_t low = 0, high = min(a.size(), b.size());
+    while(low < high) {
+        size_t middle = (low + high) / 2;
+        if(a[middle].instructions == b[middle].instructions && a[middle].hash == b[middle].hash) low = middle + 1;
+        else high = middle;
+    }
+    //If a run is only longer, the first difference is its checkpoint after the end of the other one
+    return low;
+}
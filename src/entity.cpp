@@ -1,5 +1,6 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
+#include <cstring>
 #include <vector>
 
 #include "entity.hpp"
@@ -18,6 +19,8 @@ Entity::Entity(Vector2f ppos, SDL_Texture* ptexture, Uint16 h, Uint16 w) :pos(pp
     currentFrame.h = h;
 }
 
+Entity::Entity(Vector2f ppos, SDL_Texture* ptexture, SDL_Rect frame) :pos(ppos), currentFrame(frame), texture(ptexture) {}
+
 Vector2f& Entity::getPos() {
     return pos;
 }
@@ -54,7 +57,8 @@ void Entity::setCurrentFrame(SDL_Rect rect) {
     currentFrame = rect;
 }
 
-TextEntity::TextEntity(Vector2f ppos, SDL_Texture* ptexture, Font* pfont) :pos(ppos), texture(ptexture), font(pfont) {
+TextEntity::TextEntity(Vector2f ppos, SDL_Texture* ptexture, Font* pfont) :pos(ppos), texture(ptexture), font(pfont), length(0),
+    highlight(false) {
 }
 
 Vector2f& TextEntity::getPos() {
@@ -63,18 +67,10 @@ Vector2f& TextEntity::getPos() {
 
 void TextEntity::setX(float px) {
     pos.x = px;
-    Uint16 size = textEntity.size();
-    for(Uint16 i = 0; i < size; i++) {
-        textEntity[i].setX(px + (i * 3));
-    }
 }
 
 void TextEntity::setY(float py) {
     pos.y = py;
-    Uint16 size = textEntity.size();
-    for(Uint16 i = 0; i < size; i++) {
-        textEntity[i].setY(py);
-    }
 }
 
 void TextEntity::setXY(float px, float py) {
@@ -83,101 +79,84 @@ void TextEntity::setXY(float px, float py) {
 
 void TextEntity::setXY(Vector2f ppos) {
     pos = ppos;
-    Uint16 size = textEntity.size();
-    for(Uint16 i = 0; i < size; i++) {
-        textEntity[i].setXY(ppos.x + (i * 3) , ppos.y);
-    }
 }
 
-void TextEntity::buildTextEntity(string ptext) {
-    Uint16 length = ptext.length();
-    bool sameLenght = text.length() == length;
-    char c;
-    text = ptext;
-    if(sameLenght) {
-        for(Uint16 i = 0; i < length; i++) {
-            c = ptext[i];
-            changeAt(i, c);
-        }
-    }
-    else {
-        textEntity.clear();
-        for(Uint16 i = 0; i < length; i++) {
-            Entity e = Entity(Vector2f(pos.x + (i * 3), pos.y), texture);
-            c = ptext[i];
-            textEntity.push_back(e);
-            textEntity[i].setCurrentFrame(font->letters[int(c)]);
-        }
-    }
-    
+void TextEntity::buildTextEntity(const string& ptext) {
+    length = min(ptext.length(), size_t(TEXT_CAPACITY));
+    memcpy(glyphs, ptext.data(), length);
 }
 
 void TextEntity::changeAt(Uint16 indx, char c) {
-    if(indx < Uint16(text.length())) {
-        text[indx] = c;
-        textEntity[indx].setCurrentFrame(font->letters[int(c)]);
-    }
-    else {
-        text += c;
-        textEntity.push_back(Entity(Vector2f(pos.x + (textEntity.size() * 3), pos.y), texture));
-        textEntity[textEntity.size() - 1].setCurrentFrame(font->letters[int(c)]);
-    }
+    if(indx < length)
+        glyphs[indx] = c;
+    else if(length < TEXT_CAPACITY)
+        glyphs[length++] = c;
 }
 
-void TextEntity::changeAt(Uint16 indx, Entity e) {
-    if(indx < Uint16(textEntity.size())) {
-        text[indx] = '?';
-        textEntity[indx] = e;
+void TextEntity::setHex(Uint16 indx, Uint16 n, Uint8 digits) {
+    static const char nibbles[] = "0123456789ABCDEF";
+    for(Int16 i = digits - 1; i >= 0; i--) {
+        changeAt(indx + i, nibbles[n & 0xF]);
+        n >>= 4;
     }
-    else {
-        text += '?';
-        textEntity.push_back(e);
+}
+
+void TextEntity::setChars(Uint16 indx, const char* s, Uint16 length) {
+    for(Uint16 i = 0; i < length; i++) {
+        changeAt(indx + i, s[i]);
     }
 }
 
-vector<Entity>* TextEntity::getTextEntity() {
-    return &textEntity;
+Uint8 TextEntity::getLength() {
+    return length;
 }
 
-TextEntity& TextEntity::operator = (string ptext) {
-    this->buildTextEntity(ptext);
-    return *this;
+const char* TextEntity::getGlyphs() {
+    return glyphs;
 }
 
-TextEntity& TextEntity::operator += (string ptext) {
-    this->text += ptext;
-    Uint16 lenght = this->text.length(), size = this->textEntity.size();
-    char c;
-    while(size < lenght) {
-        Entity e = Entity(Vector2f(pos.x + (size * 3), pos.y), texture);
-        c = text[size];
-        this->textEntity.push_back(e);
-        this->textEntity[size].setCurrentFrame(this->font->letters[int(c)]);
-        size = this->textEntity.size();
-    }
+SDL_Texture* TextEntity::getTexture() {
+    return texture;
+}
+
+Font* TextEntity::getFont() {
+    return font;
+}
+
+void TextEntity::setHighlight(bool phighlight) {
+    highlight = phighlight;
+}
+
+SDL_Color TextEntity::getColor() {
+    SDL_Color normal = {255, 255, 255, 255}, highlighted = {255, 200, 60, 255};
+    return highlight ? highlighted : normal;
+}
+
+TextEntity& TextEntity::operator = (const string& ptext) {
+    this->buildTextEntity(ptext);
     return *this;
 }
 
-TextEntity& TextEntity::operator += (Entity e) {
-    this->text += '?';
-    e.setXY(pos.x + (textEntity.size() * 3), pos.y);
-    this->textEntity.push_back(e);
+TextEntity& TextEntity::operator += (const string& ptext) {
+    for(char c : ptext) {
+        changeAt(length, c);
+    }
     return *this;
 }
 
-Button::Button(Vector2f ppos, HitBox2d phitbox, SDL_Texture* pnormal, SDL_Texture* ppressed)
-    :Entity(ppos, pnormal), hitbox(phitbox), normal(pnormal), pressed(ppressed) {}
+Button::Button(Vector2f ppos, HitBox2d phitbox, SDL_Texture* ptexture, SDL_Rect pnormal, SDL_Rect ppressed)
+    :Entity(ppos, ptexture, pnormal), hitbox(phitbox), normal(pnormal), pressed(ppressed) {}
 
 void Button::action(void (*func)(int)) {
     func(2);
 }
 
 void Button::changeNormal() {
-    texture = normal;
+    currentFrame = normal;
 }
 
 void Button::changePressed() {
-    texture = pressed;
+    currentFrame = pressed;
 }
 
 HitBox2d* Button::getHitBox() {
@@ -0,0 +1,345 @@
+#ifndef _WIN32
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <cstdlib>
+#include <cstring>
+
+#include "gdbstub.hpp"
+#include "unixsocket.hpp"
+
+using namespace std;
+
+//A debugger that disconnects must not kill the simulator with SIGPIPE
+#ifdef MSG_NOSIGNAL
+#define GDB_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define GDB_SEND_FLAGS 0
+#endif
+
+//Register description sent to the debugger, the numbers are the ones of the g, p and P packets
+static const char targetXml[] =
+    "<?xml version=\"1.0\"?><!DOCTYPE target SYSTEM \"gdb-target.dtd\"><target version=\"1.0\">"
+    "<feature name=\"org.risc-cpu.core\">"
+    "<reg name=\"r0\" bitsize=\"16\" regnum=\"0\"/><reg name=\"r1\" bitsize=\"16\"/><reg name=\"r2\" bitsize=\"16\"/>"
+    "<reg name=\"r3\" bitsize=\"16\"/><reg name=\"r4\" bitsize=\"16\"/><reg name=\"r5\" bitsize=\"16\"/>"
+    "<reg name=\"r6\" bitsize=\"16\"/><reg name=\"r7\" bitsize=\"16\"/><reg name=\"r8\" bitsize=\"16\"/>"
+    "<reg name=\"r9\" bitsize=\"16\"/><reg name=\"ra\" bitsize=\"16\"/><reg name=\"rb\" bitsize=\"16\"/>"
+    "<reg name=\"rc\" bitsize=\"16\"/><reg name=\"rd\" bitsize=\"16\"/><reg name=\"re\" bitsize=\"16\"/>"
+    "<reg name=\"rf\" bitsize=\"16\"/><reg name=\"pc\" bitsize=\"16\" type=\"code_ptr\"/>"
+    "<reg name=\"ir\" bitsize=\"16\"/><reg name=\"sr\" bitsize=\"16\"/><reg name=\"ar\" bitsize=\"16\"/>"
+    "<reg name=\"dr\" bitsize=\"16\"/><reg name=\"sp\" bitsize=\"16\" type=\"data_ptr\"/>"
+    "</feature></target>";
+
+/**
+ * @brief Function to write a word as the target stores it, low byte first
+ * @param n The word
+ * @returns The hexadecimal string
+*/
+static string wordToHex(Uint16 n) {
+    return math::Uint8ToHexstr(n) + math::Uint8ToHexstr(n >> 8);
+}
+
+/**
+ * @brief Function to read a word written by wordToHex
+ * @param s The hexadecimal string, at least 4 chars
+ * @returns The word
+*/
+static Uint16 hexToWord(const string& s) {
+    return math::hexstrToUint8(s.substr(0, 2)) | (math::hexstrToUint8(s.substr(2, 2)) << 8);
+}
+
+/**
+ * @brief Function to check if a string is made of hexadecimal digits
+ * @param s The string
+ * @returns True if it is not empty and only has hexadecimal digits
+*/
+static bool isHex(const string& s) {
+    return !s.empty() && s.find_first_not_of("0123456789abcdefABCDEF") == string::npos;
+}
+
+GdbStub::GdbStub(Machine* pmachine, Logger* plogger) :machine(pmachine), logger(plogger), server(-1), client(-1),
+    breakpointCount(0) {}
+
+GdbStub::~GdbStub() {
+    close();
+}
+
+bool GdbStub::serve(string address) {
+    if(!listen(address)) {
+        logger->log(LOG_ERROR, LOG_GDB_FAILED, address);
+        return false;
+    }
+    logger->log(LOG_INFO, LOG_GDB_LISTENING, address);
+#ifndef _WIN32
+    client = accept(server, NULL, NULL);
+    if(client < 0) {
+        logger->log(LOG_ERROR, LOG_GDB_FAILED, address);
+        close();
+        return false;
+    }
+    //The packets are small and answered one at a time
+    int on = 1;
+    if(path == "") setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    logger->log(LOG_SUCCESS, LOG_GDB_CONNECTED);
+    bool done = false;
+    string packet;
+    while(!done && receive(packet)) {
+        string reply = handle(packet, done);
+        //A kill is not answered
+        if(packet != "k") send(reply);
+    }
+    logger->log(LOG_INFO, LOG_GDB_DISCONNECTED);
+#endif
+    close();
+    return true;
+}
+
+bool GdbStub::listen(string address) {
+#ifdef _WIN32
+    return false;
+#else
+    bool port = address.find_first_not_of("0123456789") == string::npos && !address.empty();
+    if(port) {
+        //Only the local host, the stub gives full control over the machine
+        sockaddr_in in;
+        memset(&in, 0, sizeof(in));
+        in.sin_family = AF_INET;
+        in.sin_port = htons(atoi(address.c_str()));
+        in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        server = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        if(server >= 0) setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if(server < 0 || bind(server, (sockaddr*)&in, sizeof(in)) < 0 || ::listen(server, 1) < 0) {
+            close();
+            return false;
+        }
+        return true;
+    }
+    server = UnixSocket::listen(address, 1);
+    if(server < 0) return false;
+    path = address;
+    return true;
+#endif
+}
+
+void GdbStub::close() {
+#ifndef _WIN32
+    if(client >= 0) ::close(client);
+    if(server >= 0) ::close(server);
+    if(path != "") unlink(path.c_str());
+#endif
+    client = server = -1;
+    path = "";
+}
+
+bool GdbStub::receiveByte(char& c) {
+    if(input.empty()) {
+#ifdef _WIN32
+        return false;
+#else
+        char buffer[GDB_MAX_PACKET];
+        ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+        if(n <= 0) return false;
+        input.assign(buffer, n);
+#endif
+    }
+    c = input[0];
+    input.erase(0, 1);
+    return true;
+}
+
+bool GdbStub::receive(string& packet) {
+    char c;
+    while(true) {
+        //Everything before the start of a packet is an acknowledgment or an interrupt already served
+        do {
+            if(!receiveByte(c)) return false;
+            if(c == '-' && last != "") send(last);
+        } while(c != '$');
+        packet = "";
+        while(receiveByte(c) && c != '#') packet += c;
+        char sum[3] = {0, 0, 0};
+        if(!receiveByte(sum[0]) || !receiveByte(sum[1])) return false;
+        Uint8 checksum = 0;
+        for(char p : packet) checksum += Uint8(p);
+#ifndef _WIN32
+        bool valid = isHex(sum) && math::hexstrToUint8(sum) == checksum;
+        ::send(client, valid ? "+" : "-", 1, GDB_SEND_FLAGS);
+        if(valid) break;
+#else
+        return false;
+#endif
+    }
+    //Escaped bytes, only sent by the debugger in binary packets
+    for(size_t i = 0; i < packet.size(); i++)
+        if(packet[i] == '}' && i + 1 < packet.size()) packet.replace(i, 2, 1, char(packet[i + 1] ^ 0x20));
+    return true;
+}
+
+void GdbStub::send(string packet) {
+    Uint8 checksum = 0;
+    for(char p : packet) checksum += Uint8(p);
+    last = packet;
+    string data = "$" + packet + "#" + math::Uint8ToHexstr(checksum);
+#ifndef _WIN32
+    for(size_t sent = 0; sent < data.size(); ) {
+        ssize_t n = ::send(client, data.data() + sent, data.size() - sent, GDB_SEND_FLAGS);
+        if(n <= 0) return;
+        sent += n;
+    }
+#endif
+}
+
+bool GdbStub::interrupted() {
+#ifdef _WIN32
+    return false;
+#else
+    pollfd p = {client, POLLIN, 0};
+    if(input.empty() && poll(&p, 1, 0) <= 0) return false;
+    char c;
+    //A closed connection stops the target too, the next receive sees it
+    if(!receiveByte(c)) return true;
+    if(c == 0x03) return true;
+    input.insert(0, 1, c);
+    return false;
+#endif
+}
+
+string GdbStub::handle(const string& packet, bool& done) {
+    CentralProcessingUnit& CPU = machine->CPU;
+    string reply;
+    if(packet.empty()) return reply;
+    string args = packet.substr(1);
+    size_t comma = args.find(','), colon = args.find(':'), equals = args.find('=');
+    switch(packet[0]) {
+        case '?':
+            return stopReply();
+        case 'g':
+            for(Uint8 r = 0; r < GDB_REGISTERS; r++) reply += wordToHex(CPU.getRegister(r));
+            return reply;
+        case 'G':
+            if(args.size() < GDB_REGISTERS * 4 || !isHex(args)) return "E01";
+            for(Uint8 r = 0; r < GDB_REGISTERS; r++) CPU.setRegister(r, hexToWord(args.substr(r * 4, 4)));
+            return "OK";
+        case 'p': {
+            Uint32 r = strtoul(args.c_str(), NULL, 16);
+            return (r < GDB_REGISTERS) ? wordToHex(CPU.getRegister(r)) : "E01";
+        }
+        case 'P': {
+            if(equals == string::npos || !isHex(args.substr(equals + 1)) || args.size() < equals + 5) return "E01";
+            Uint32 r = strtoul(args.c_str(), NULL, 16);
+            if(r >= GDB_REGISTERS) return "E01";
+            CPU.setRegister(r, hexToWord(args.substr(equals + 1)));
+            return "OK";
+        }
+        case 'm': {
+            if(comma == string::npos) return "E01";
+            Uint32 address = strtoul(args.c_str(), NULL, 16);
+            Uint32 length = min(strtoul(args.c_str() + comma + 1, NULL, 16), (unsigned long)(GDB_MAX_PACKET / 2));
+            //The address space wraps, like the CPU reads
+            for(Uint32 i = 0; i < length; i++) reply += math::Uint8ToHexstr(machine->CM.get(Uint16(address + i)));
+            return reply;
+        }
+        case 'M': {
+            if(comma == string::npos || colon == string::npos) return "E01";
+            Uint32 address = strtoul(args.c_str(), NULL, 16);
+            Uint32 length = strtoul(args.c_str() + comma + 1, NULL, 16);
+            string data = args.substr(colon + 1);
+            if(data.size() < length * 2 || (length > 0 && !isHex(data))) return "E01";
+            //Through the bus, so the cells outside the ram size are discarded and the memory hash is kept
+            SystemBus bus = machine->SB;
+            for(Uint32 i = 0; i < length; i++) {
+                machine->SB.writeAddress(Uint16(address + i));
+                machine->SB.writeData(math::hexstrToUint8(data.substr(i * 2, 2)));
+                machine->SB.writeControl(ControlBus(WRITE, MEMORY, BYTE));
+                machine->CM.operate();
+            }
+            machine->SB = bus;
+            return "OK";
+        }
+        case 'Z':
+        case 'z': {
+            //Software and hardware breakpoints are the same thing, the PC is checked after every instruction
+            if(args.size() < 3 || (args[0] != '0' && args[0] != '1') || args[1] != ',') return reply;
+            Uint16 address = strtoul(args.c_str() + 2, NULL, 16);
+            if(breakpoints[address] != (packet[0] == 'Z')) {
+                breakpoints[address] = packet[0] == 'Z';
+                breakpointCount += (packet[0] == 'Z') ? 1 : -1;
+            }
+            return "OK";
+        }
+        case 's':
+        case 'c':
+            if(isHex(args)) CPU.setRegister(16, strtoul(args.c_str(), NULL, 16));
+            return resume(packet[0] == 's');
+        case 'k':
+            done = true;
+            return reply;
+        case 'D':
+            done = true;
+            return "OK";
+        case 'H':
+        case 'T':
+            return "OK";
+        case 'q':
+            if(packet.compare(0, 10, "qSupported") == 0)
+                return "PacketSize=" + to_string(GDB_MAX_PACKET) + ";qXfer:features:read+";
+            if(packet.compare(0, 31, "qXfer:features:read:target.xml:") == 0) {
+                Uint32 offset = strtoul(packet.c_str() + 31, NULL, 16);
+                comma = packet.find(',', 31);
+                Uint32 length = (comma != string::npos) ? strtoul(packet.c_str() + comma + 1, NULL, 16) : 0;
+                string xml = targetXml;
+                if(offset >= xml.size()) return "l";
+                string chunk = xml.substr(offset, min(length, Uint32(GDB_MAX_PACKET - 1)));
+                return ((offset + chunk.size() < xml.size()) ? "m" : "l") + chunk;
+            }
+            if(packet == "qAttached") return "1";
+            if(packet == "qC") return "QC1";
+            if(packet == "qfThreadInfo") return "m1";
+            if(packet == "qsThreadInfo") return "l";
+            if(packet == "qOffsets") return "Text=0;Data=0;Bss=0";
+            return reply;
+        case 'v':
+            if(packet == "vKill" || packet.compare(0, 6, "vKill;") == 0) {
+                done = true;
+                return "OK";
+            }
+            //vCont is not supported, so the debugger falls back to s and c
+            return reply;
+    }
+    return reply;
+}
+
+string GdbStub::resume(bool single) {
+    CentralProcessingUnit& CPU = machine->CPU;
+    const Engine& engine = Engines::get(ENGINE_FASTEST);
+    if(single) {
+        engine.run(CPU, 1);
+        return stopReply();
+    }
+    while(!Engines::stopped(CPU)) {
+        if(breakpointCount == 0) engine.run(CPU, GDB_BLOCK);
+        else {
+            //A breakpoint on the first instruction is not hit, the debugger steps over it before continuing
+            for(Uint32 i = 0; i < GDB_BLOCK; i++) {
+                if(engine.run(CPU, 1) == 0) break;
+                if(breakpoints[CPU.getPC()]) return "S05";
+            }
+        }
+        if(interrupted()) return "S02";
+    }
+    return stopReply();
+}
+
+string GdbStub::stopReply() {
+    Uint8 now, next;
+    machine->CPU.getPhases(now, next);
+    //A HLT ends the program, an invalid instruction is reported as an illegal instruction
+    if(next == 0xF0) return "W00";
+    return (next == 0xFF) ? "S04" : "S05";
+}
@@ -0,0 +1,35 @@
+#include <cstring>
+
+#include "heatmap.hpp"
+
+using namespace std;
+
+MemoryHeatmap::MemoryHeatmap() {
+    clear();
+    //A few accesses per frame are already visible, a hot loop saturates the color
+    levels[0] = 0;
+    for(Uint32 c = 1; c < 256; c++) levels[c] = HEAT_MIN_LEVEL + (c * (255 - HEAT_MIN_LEVEL) + 127) / 255;
+}
+
+void MemoryHeatmap::clear() {
+    memset(counts, 0, sizeof(counts));
+}
+
+bool MemoryHeatmap::decay() {
+    bool changed = false;
+    for(Uint8 k = 0; k < HEAT_KINDS; k++) {
+        Uint8* c = counts[k];
+        for(Uint32 i = 0; i < HEAT_SIDE * HEAT_SIDE; i++) {
+            //Rounded down, so every counter reaches 0
+            changed |= c[i] != 0;
+            c[i] = (c[i] * HEAT_DECAY) >> 3;
+        }
+    }
+    return changed;
+}
+
+void MemoryHeatmap::render(Uint32* pixels) {
+    for(Uint32 i = 0; i < HEAT_SIDE * HEAT_SIDE; i++)
+        pixels[i] = 0xFF000000 | (levels[counts[HEAT_WRITE][i]] << 16) | (levels[counts[HEAT_EXECUTE][i]] << 8)
+            | levels[counts[HEAT_READ][i]];
+}
@@ -0,0 +1,141 @@
+#include <cstring>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "image.hpp"
+#include "risc.hpp"
+
+using namespace std;
+
+/**
+ * @brief Function to calculate the FNV-1a checksum of a buffer
+ * @param data The buffer
+ * @param length The buffer length
+ * @returns The checksum
+*/
+static Uint32 checksum(const Uint8* data, size_t length) {
+    Uint32 h = 0x811C9DC5;
+    for(size_t i = 0; i < length; i++) {
+        h ^= data[i];
+        h *= 0x01000193;
+    }
+    return h;
+}
+
+/**
+ * @brief Function to validate a mapped image and copy its segments in the central memory
+ * @param data The image bytes
+ * @param length The image length
+ * @param cm The central memory pointer
+ * @param settings The interpreter settings
+ * @param logger The logger
+ * @returns True if loaded
+*/
+static bool parse(const Uint8* data, size_t length, CentralMemory* cm, InterpreterSettings* settings, Logger* logger) {
+    ImageHeader header;
+    if(length < sizeof(header)) {
+        logger->log(LOG_ERROR, LOG_IMAGE_TRUNCATED, settings->file);
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if(header.magic != IMAGE_MAGIC || header.version != IMAGE_VERSION) {
+        logger->log(LOG_ERROR, LOG_IMAGE_UNKNOWN, settings->file);
+        return false;
+    }
+    const Uint8* p = data + sizeof(header);
+    const Uint8* end = data + length;
+    if(checksum(p, end - p) != header.checksum) {
+        logger->log(LOG_ERROR, LOG_IMAGE_CORRUPTED, settings->file);
+        return false;
+    }
+    cm->reset(header.ramSize);
+    for(Uint16 i = 0; i < header.segmentCount; i++) {
+        ImageSegmentHeader segment;
+        if(Uint32(end - p) < sizeof(segment)) return false;
+        memcpy(&segment, p, sizeof(segment));
+        p += sizeof(segment);
+        if(Uint32(end - p) < segment.length) return false;
+        cm->loadBytes(segment.address, p, segment.length);
+        p += segment.length;
+    }
+    settings->ramSize = header.ramSize;
+    settings->start = header.start;
+    return true;
+}
+
+ProgramImage::ProgramImage() :load(0x0), start(0x0), ramSize(0) {}
+
+bool ImageFile::write(string path, const ProgramImage& image) {
+    vector<Uint8> payload;
+    ImageSegmentHeader segment;
+    segment.address = image.load;
+    segment.reserved = 0;
+    segment.length = image.bytes.size();
+    payload.resize(sizeof(segment));
+    memcpy(payload.data(), &segment, sizeof(segment));
+    payload.insert(payload.end(), image.bytes.begin(), image.bytes.end());
+    for(const ImageSymbol& s : image.symbols) {
+        Uint8 nameLength = min(s.name.length(), size_t(0xFF));
+        payload.push_back(s.address & 0xFF);
+        payload.push_back(s.address >> 8);
+        payload.push_back(nameLength);
+        payload.insert(payload.end(), s.name.begin(), s.name.begin() + nameLength);
+    }
+    ImageHeader header;
+    header.magic = IMAGE_MAGIC;
+    header.version = IMAGE_VERSION;
+    header.segmentCount = 1;
+    header.load = image.load;
+    header.start = image.start;
+    header.ramSize = image.ramSize;
+    header.symbolCount = image.symbols.size();
+    header.checksum = checksum(payload.data(), payload.size());
+    ofstream file(path, ios::binary);
+    if(!file) return false;
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)payload.data(), payload.size());
+    return bool(file);
+}
+
+bool ImageFile::writeHex(string path, const ProgramImage& image) {
+    string text;
+    text.reserve(image.bytes.size() * 3);
+    for(Uint8 b : image.bytes) {
+        text += math::Uint8ToHexstr(b);
+        text += '\n';
+    }
+    ofstream file(path, ios::binary);
+    if(!file) return false;
+    file.write(text.data(), text.length());
+    return bool(file);
+}
+
+bool ImageFile::load(string path, CentralMemory* cm, InterpreterSettings* settings, Logger* logger) {
+#ifdef _WIN32
+    ifstream file(path, ios::binary | ios::ate);
+    if(!file) return false;
+    vector<Uint8> data(file.tellg());
+    file.seekg(0);
+    file.read((char*)data.data(), data.size());
+    return parse(data.data(), data.size(), cm, settings, logger);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) return false;
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+    bool loaded = parse((const Uint8*)data, st.st_size, cm, settings, logger);
+    munmap(data, st.st_size);
+    return loaded;
+#endif
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <vector>
+#include <sstream>
 #include <cstdio>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
@@ -9,6 +10,11 @@
 #include "entity.hpp"
 #include "utils.hpp"
 #include "risc.hpp"
+#include "watcher.hpp"
+#include "viewer.hpp"
+#include "atlas.hpp"
+#include "session.hpp"
+#include "gdbstub.hpp"
 
 using namespace std;
 
@@ -16,90 +22,114 @@ int main(int argc, char* args[]) {
     //Variables
     Logger logger;
     Settings settings = JsonManager::getSettings(); //Variable to store the settings from the json
-    Font font = JsonManager::getFont(); //Variable to store all the letters rects
+    Font font; //Variable to store all the letters rects, in the atlas
     bool running = true; //Variable to know if it has to continue running or not
     SDL_Event event; //Variable to store window events
     Uint32 flags = JsonManager::getFlags(settings);
-    Uint16 msStep = 1000 / settings.win.maxFps, fps = 1; //Variables to regulate the framerate
-    Uint64 previousSecond, currentSecond;
-    long int msNow, msNext = SDL_GetTicks();
+    //Variables to regulate the framerate, in performance counter ticks
+    Uint64 frequency = SDL_GetPerformanceFrequency(), frameTicks = frequency / settings.win.maxFps;
+    Uint64 now, nextFrame, frameStart, renderStart;
+    Uint64 renderTicks = 0; //Average render cost, the rest of the frame is given to the simulation
+    Uint16 msIdle = 250; //Maximum sleep while paused, so the hot reload is still checked
+    //Statistics of the current second
+    Uint64 statsStart, simTicks = 0, workTicks = 0, instructions = 0;
+    Uint64 clockStart = 0, cycles = 0; //Emulated clock, cycles run since it started
+    Uint32 fps = 0;
     string fpsString = "000", fpsCounter, fpsText = "FPS:";
+    char statsText[32];
     Vector2d cursorPosition, guiCursorPosition;
     Uint8 cursorState = 0; //0 -> normal, 1 -> hover, 2 -> normal clicked, 3 -> hover clicked
-    Cursor cursor = JsonManager::getCursor();
+    Cursor cursor;
     Uint8 inHitboxes = 0, phaseNow, phaseNext;
-    Uint16 cellsStartAddress = 0x0; //For CM rendering
     bool clicked = false, refresh = true, constantRefresh = false;
+    bool redraw = true; //If the window has to be drawn again
     bool fullInstruction = false, constantFullInstruction = false, progressBarAll = false;
     Uint8 key; //For keyboard input
     bool shiftPressed = false;
+    string l0, l1, l2, l3; //Monitor lines, kept to reuse their buffers
+    char bits[4]; //For SR and CB rendering
+    MemoryHeatmap heatmap;
+    vector<Uint32> heatmapPixels(HEAT_SIDE * HEAT_SIDE);
+    bool heatmapShown = false, heatmapHot = false; //Hot while some counter has not faded yet
 
-    //Capturing cout in log file
+    //Capturing the output in log file
     if(settings.console.log) freopen("log.txt", "w", stdout);
     logger.setColors(settings.console);
+    logger.start();
+    //Debugging with GDB, without the GUI
+    if(argc == 3 && string(args[1]) == "--gdb") {
+        Machine machine;
+        machine.CM.loadProgram(&settings.interpreter, &logger);
+        machine.CPU.reset(settings.interpreter);
+        machine.IOD.input(0x0);
+        GdbStub stub(&machine, &logger);
+        return stub.serve(args[2]) ? 0 : 1;
+    }
+    //Decoding the textures while everything else is initialized
+    if(!IMG_Init(IMG_INIT_PNG)) {
+        logger.log(LOG_ERROR, LOG_IMG_FAILED, SDL_GetError());
+    }
+    else {
+        logger.log(LOG_SUCCESS, LOG_IMG);
+    }
+    TextureAtlas atlas;
+    atlas.start(&logger);
 
     //Interpreter
-    SystemBus SB;
-    CentralMemory CM(&SB);
-    InputOutputDevices IOD(&SB);
-    CentralProcessingUnit CPU(&SB, &CM, &IOD);
+    Machine machine;
+    SystemBus& SB = machine.SB;
+    CentralMemory& CM = machine.CM;
+    InputOutputDevices& IOD = machine.IOD;
+    CentralProcessingUnit& CPU = machine.CPU;
     CM.loadProgram(&settings.interpreter, &logger);
     CPU.reset(settings.interpreter);
     IOD.input(0x0);
+    //Every key and button is recorded with where the CPU was, so the session can be replayed
+    SessionRecorder recorder;
+    if(settings.interpreter.record != "") {
+        if(recorder.start(settings.interpreter.record, &machine, settings.interpreter))
+            logger.log(LOG_INFO, LOG_RECORDING, settings.interpreter.record);
+        else
+            logger.log(LOG_ERROR, LOG_RECORD_FAILED, settings.interpreter.record);
+    }
+    ProgramWatcher watcher;
+    ProgramUpdate programUpdate;
+    if(settings.interpreter.hotReload && !watcher.start(settings.interpreter))
+        logger.log(LOG_WARNING, LOG_WATCH_FAILED, settings.interpreter.file);
 
-    //SDL and IMG initialization
-    cout << logger.getStringTime();
+    //SDL initialization
     if(SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) > 0) {
-        cout << logger.error << "SDL Initialization FAILED! SDL_ERROR: " << SDL_GetError() << logger.reset << endl;
+        logger.log(LOG_ERROR, LOG_SDL_FAILED, SDL_GetError());
     }
     else {
-        cout << logger.success << "SDL Initialized Succesfully" << logger.reset << endl;
+        logger.log(LOG_SUCCESS, LOG_SDL);
     }
-    cout << logger.getStringTime();
-    if(!IMG_Init(IMG_INIT_PNG)) {
-        cout << logger.error << "IMG Initialization FAILED! IMG_ERROR: " << SDL_GetError() << logger.reset << endl;
-    }
-    else {
-        cout << logger.success << "IMG Initialized Succesfully" << logger.reset << endl;
-    }
-    //Printing the settings
-    cout << logger.getStringTime() << logger.info << "Settings:" << endl << settings << logger.reset << endl;
+    //Printing the settings, one record per line
+    stringstream settingsText;
+    settingsText << "Settings:" << endl << settings;
+    for(string line; getline(settingsText, line); ) logger.log(LOG_INFO, LOG_TEXT, line);
     //Render the window
     RenderWindow window("RISC-CPU SIMULATOR v1.1.3", settings.win.width, settings.win.height,
                         flags, &logger, &settings, "res/icon-64.png");
     SDL_ShowCursor(0);
 
-    //Loading the textures
-    SDL_Texture* cursorTexture = window.loadTexture("res/cursor.png");
-    SDL_Texture* iconTexture = window.loadTexture("res/icon.png");
-    SDL_Texture* fontTexture = window.loadTexture("res/font.png");
-    SDL_Texture* cpuGuiTexture = window.loadTexture("res/cpu_gui.png");
-    SDL_Texture* cmGuiTexture = window.loadTexture("res/cm_gui.png");
-    SDL_Texture* iodGuiTexture = window.loadTexture("res/iod_gui.png");
-    SDL_Texture* iodKeyTexture = window.loadTexture("res/key.png");
-    SDL_Texture* iodKeyPressedTexture = window.loadTexture("res/key_pressed.png");
-    SDL_Texture* sbGuiTexture = window.loadTexture("res/system_bus_gui.png");
-    SDL_Texture* progressBarTexture = window.loadTexture("res/progress_bar.png");
-    SDL_Texture* progressBarNowTexture = window.loadTexture("res/progress_bar_now.png");
-    SDL_Texture* progressBarNextTexture = window.loadTexture("res/progress_bar_next.png");
-    SDL_Texture* progressBarAllTexture = window.loadTexture("res/progress_bar_all.png");
-    SDL_Texture* fastTexture = window.loadTexture("res/fast_button.png");
-    SDL_Texture* playTexture = window.loadTexture("res/play_button.png");
-    SDL_Texture* nextTexture = window.loadTexture("res/next_button.png");
-    SDL_Texture* pauseTexture = window.loadTexture("res/pause_button.png");
-    SDL_Texture* reloadTexture = window.loadTexture("res/reload_button.png");
-    SDL_Texture* fastPressedTexture = window.loadTexture("res/fast_button_pressed.png");
-    SDL_Texture* playPressedTexture = window.loadTexture("res/play_button_pressed.png");
-    SDL_Texture* nextPressedTexture = window.loadTexture("res/next_button_pressed.png");
-    SDL_Texture* pausePressedTexture = window.loadTexture("res/pause_button_pressed.png");
-    SDL_Texture* reloadPressedTexture = window.loadTexture("res/reload_button_pressed.png");
-    Entity cursorEntity(Vector2f(0, 0), cursorTexture);
+    //Loading the textures, packed in a single one
+    SDL_Texture* atlasTexture = window.loadTexture(atlas.wait(), ATLAS_IMAGE);
+    SDL_Texture* fontTexture = atlasTexture;
+    SDL_Rect keyFrame = atlas.getRect(ATLAS_KEY), keyPressedFrame = atlas.getRect(ATLAS_KEY_PRESSED);
+    font = atlas.getFont();
+    cursor = atlas.getCursor();
+    Entity cursorEntity(Vector2f(0, 0), atlasTexture, cursor.pointers[0]);
+    //Memory heatmap, a pixel per cell
+    SDL_Texture* heatmapTexture = window.createStreamingTexture(HEAT_SIDE, HEAT_SIDE, "heatmap");
+    Entity heatmapEntity(Vector2f(6, 10), heatmapTexture, HEAT_SIDE, HEAT_SIDE);
     TextEntity fpsCounterEntity(Vector2f(3, 3), fontTexture, &font);
+    TextEntity statsEntity(Vector2f(111, 44), fontTexture, &font);
     //GUI backgrounds
-    Entity cpuGui(Vector2f(6, 10), cpuGuiTexture, 256, 128);
-    Entity cmGui(Vector2f(70, 10), cmGuiTexture, 256, 128);
-    Entity iodGui(Vector2f(111, 51), iodGuiTexture, 256, 128);
-    Entity sbGui(Vector2f(6, 121), sbGuiTexture, 128, 384);
+    Entity cpuGui(Vector2f(6, 10), atlasTexture, atlas.getRect(ATLAS_CPU_GUI));
+    Entity cmGui(Vector2f(70, 10), atlasTexture, atlas.getRect(ATLAS_CM_GUI));
+    Entity iodGui(Vector2f(111, 51), atlasTexture, atlas.getRect(ATLAS_IOD_GUI));
+    Entity sbGui(Vector2f(6, 121), atlasTexture, atlas.getRect(ATLAS_SB_GUI));
     //Instruction name
     TextEntity instNameTitle(Vector2f(32, 3), fontTexture, &font);
     TextEntity instNameValue(Vector2f(82, 3), fontTexture, &font);
@@ -110,20 +140,25 @@ int main(int argc, char* args[]) {
     TextEntity progressBarIdTitle(Vector2f(125, 1), fontTexture, &font);
     TextEntity progressBarOfTitle(Vector2f(133, 1), fontTexture, &font);
     TextEntity progressBarIeTitle(Vector2f(141, 1), fontTexture, &font);
-    Entity progressBarEntity(Vector2f(117, 4), progressBarTexture, 16, 64);
-    Entity progressBarNowEntity(Vector2f(117, 4), progressBarNowTexture);
-    Entity progressBarNextEntity(Vector2f(125, 4), progressBarNextTexture);
-    Entity progressBarAllEntity(Vector2f(117, 4), progressBarAllTexture, 16, 64);
+    Entity progressBarEntity(Vector2f(117, 4), atlasTexture, atlas.getRect(ATLAS_PROGRESS_BAR));
+    Entity progressBarNowEntity(Vector2f(117, 4), atlasTexture, atlas.getRect(ATLAS_PROGRESS_BAR_NOW));
+    Entity progressBarNextEntity(Vector2f(125, 4), atlasTexture, atlas.getRect(ATLAS_PROGRESS_BAR_NEXT));
+    Entity progressBarAllEntity(Vector2f(117, 4), atlasTexture, atlas.getRect(ATLAS_PROGRESS_BAR_ALL));
     //Buttons
-    Button fastButton(Vector2f(111, 12), HitBox2d(111, 12, 7, 7), fastTexture, fastPressedTexture);
-    Button playButton(Vector2f(120, 12), HitBox2d(120, 12, 7, 7), playTexture, playPressedTexture);
-    Button nextButton(Vector2f(129, 12), HitBox2d(129, 12, 7, 7), nextTexture, nextPressedTexture);
-    Button pauseButton(Vector2f(138, 12), HitBox2d(138, 12, 7, 7), pauseTexture, pausePressedTexture);
-    Button reloadButton(Vector2f(147, 12), HitBox2d(147, 12, 7, 7), reloadTexture, reloadPressedTexture);
+    Button fastButton(Vector2f(111, 12), HitBox2d(111, 12, 7, 7), atlasTexture,
+        atlas.getRect(ATLAS_FAST), atlas.getRect(ATLAS_FAST_PRESSED));
+    Button playButton(Vector2f(120, 12), HitBox2d(120, 12, 7, 7), atlasTexture,
+        atlas.getRect(ATLAS_PLAY), atlas.getRect(ATLAS_PLAY_PRESSED));
+    Button nextButton(Vector2f(129, 12), HitBox2d(129, 12, 7, 7), atlasTexture,
+        atlas.getRect(ATLAS_NEXT), atlas.getRect(ATLAS_NEXT_PRESSED));
+    Button pauseButton(Vector2f(138, 12), HitBox2d(138, 12, 7, 7), atlasTexture,
+        atlas.getRect(ATLAS_PAUSE), atlas.getRect(ATLAS_PAUSE_PRESSED));
+    Button reloadButton(Vector2f(147, 12), HitBox2d(147, 12, 7, 7), atlasTexture,
+        atlas.getRect(ATLAS_RELOAD), atlas.getRect(ATLAS_RELOAD_PRESSED));
     fpsCounter = fpsText + fpsString;
     fpsCounterEntity = fpsCounter;
     //Icon
-    Entity iconEntity(Vector2f(157, 2), iconTexture, 32, 32);
+    Entity iconEntity(Vector2f(157, 2), atlasTexture, atlas.getRect(ATLAS_ICON));
     TextEntity creditsText0(Vector2f(111, 26), fontTexture, &font);
     TextEntity creditsText1(Vector2f(111, 32), fontTexture, &font);
     TextEntity creditsText2(Vector2f(111, 38), fontTexture, &font);
@@ -180,16 +215,11 @@ int main(int argc, char* args[]) {
     //CM
     TextEntity cmTitle(Vector2f(71, 12), fontTexture, &font);
     TextEntity ramTitle(Vector2f(71, 19), fontTexture, &font);
-    vector<TextEntity> cellTitles;
-    vector<TextEntity> cellValues;
-    for(Uint16 i = 0; i <= 0xF; i++) {
-        cellTitles.push_back(TextEntity(Vector2f(71, 26 + 6 * i), fontTexture, &font));
-        cellValues.push_back(TextEntity(Vector2f(91, 26 + 6 * i), fontTexture, &font));
-        cellTitles[i] = "0x" + math::Uint16ToHexstr(i) + ":";
-        cellValues[i] = "0x00";
-    }
+    TextEntity followValue(Vector2f(83, 19), fontTexture, &font);
+    MemoryViewer viewer(Vector2f(71, 26), fontTexture, &font);
     cmTitle = "CM";
     ramTitle = "RAM";
+    followValue = "  ";
     //IOD
     TextEntity iodTitle(Vector2f(112, 53), fontTexture, &font);
     TextEntity monitorTitle(Vector2f(112, 60), fontTexture, &font);
@@ -205,22 +235,22 @@ int main(int argc, char* args[]) {
         l2 = {"a", "s", "d", "f", "g", "h", "j", "k", "l"},
         l3 = {"z", "x", "c", "v", "b", "n", "m"};
     for(Uint8 i = 0; i < 10; i++) {
-        iodKeyEntities.push_back(Entity(Vector2f(112 + (6 * i), 96), iodKeyTexture, 12, 12));
+        iodKeyEntities.push_back(Entity(Vector2f(112 + (6 * i), 96), atlasTexture, keyFrame));
         iodKeyValues.push_back(TextEntity(Vector2f(113 + (6 * i), 97), fontTexture, &font));
         iodKeyValues[i] = l0[i];
     }
     for(Uint8 i = 0; i < 10; i++) {
-        iodKeyEntities.push_back(Entity(Vector2f(113 + (6 * i), 102), iodKeyTexture, 12, 12));
+        iodKeyEntities.push_back(Entity(Vector2f(113 + (6 * i), 102), atlasTexture, keyFrame));
         iodKeyValues.push_back(TextEntity(Vector2f(114 + (6 * i), 103), fontTexture, &font));
         iodKeyValues[i + 10] = l1[i];
     }
     for(Uint8 i = 0; i < 9; i++) {
-        iodKeyEntities.push_back(Entity(Vector2f(114 + (6 * i), 108), iodKeyTexture, 12, 12));
+        iodKeyEntities.push_back(Entity(Vector2f(114 + (6 * i), 108), atlasTexture, keyFrame));
         iodKeyValues.push_back(TextEntity(Vector2f(115 + (6 * i), 109), fontTexture, &font));
         iodKeyValues[i + 20] = l2[i];
     }
     for(Uint8 i = 0; i < 7; i++) {
-        iodKeyEntities.push_back(Entity(Vector2f(117 + (6 * i), 114), iodKeyTexture, 12, 12));
+        iodKeyEntities.push_back(Entity(Vector2f(117 + (6 * i), 114), atlasTexture, keyFrame));
         iodKeyValues.push_back(TextEntity(Vector2f(118 + (6 * i), 115), fontTexture, &font));
         iodKeyValues[i + 29] = l3[i];
     }}
@@ -246,38 +276,56 @@ int main(int argc, char* args[]) {
     cbValue = "DWB";
 
     //Running
-    previousSecond = SDL_GetTicks() / 1000;
+    statsStart = nextFrame = SDL_GetPerformanceCounter();
     while(running) {
         window.calculateScale();
-        msNow = SDL_GetTicks();
-        if(!(msNext <= msNow)) {
-            //Framerate regulation
-            SDL_Delay(msNext - msNow);
+        now = SDL_GetPerformanceCounter();
+        if(now < nextFrame) {
+            //Framerate regulation, rounded up so it never spins, the cadence absorbs the extra
+            SDL_Delay(((nextFrame - now) * 1000 + frequency - 1) / frequency);
         }
         else {
+            //Paused and nothing changed, sleeping until an event arrives instead of drawing the same frame
+            if(!redraw && !refresh && !constantRefresh && !fullInstruction && !constantFullInstruction && !heatmapHot) {
+                redraw = SDL_WaitEventTimeout(NULL, msIdle) == 1;
+                now = SDL_GetPerformanceCounter();
+            }
+            frameStart = now;
             //FPS counting
             if(settings.win.fpsCounter) {
-                currentSecond = msNow / 1000;
-                if(currentSecond == previousSecond) {
+                if(now - statsStart < frequency) {
                     fps++;
                 }
                 else {
-                    previousSecond = msNow / 1000;
-                    fpsString = to_string(fps);
+                    //Frame and simulation times are averages per frame, in ms
+                    double frames = max(fps, Uint32(1)), seconds = double(now - statsStart) / frequency;
+                    fpsString = to_string(Uint32(fps / seconds + 0.5));
                     fpsCounter = fpsText + fpsString;
                     fpsCounterEntity = fpsCounter;
+                    snprintf(statsText, sizeof(statsText), "MIPS:%.1f F:%.1f S:%.1f", instructions / seconds / 1000000,
+                        workTicks * 1000.0 / frequency / frames, simTicks * 1000.0 / frequency / frames);
+                    statsEntity = statsText;
+                    statsStart = now;
                     fps = 1;
+                    simTicks = workTicks = instructions = 0;
                 }
             }
-            msNext = msNow + msStep;
+            //The cadence is kept, unless the frame is already late
+            nextFrame += frameTicks;
+            if(nextFrame < now) nextFrame = now + frameTicks;
             clicked = false;
             //Controls
             while(SDL_PollEvent(&event)) {
+                redraw = true;
                 SDL_Scancode code = event.key.keysym.scancode;
                 switch(event.type) {
                     case SDL_QUIT:
                         running = false;
-                        cout << logger.getStringTime() << logger.info << "Windwow Closed" << logger.reset << endl;
+                        logger.log(LOG_INFO, LOG_WINDOW_CLOSED);
+                        break;
+                    case SDL_RENDER_TARGETS_RESET:
+                    case SDL_RENDER_DEVICE_RESET:
+                        window.invalidateStaticLayer();
                         break;
                     case SDL_MOUSEBUTTONDOWN:
                         if(cursorState == 0 || cursorState == 1) cursorState += 2;
@@ -288,20 +336,34 @@ int main(int argc, char* args[]) {
                         break;
                     case SDL_MOUSEWHEEL:
                             refresh = true;
-                            if(event.wheel.y < 0) {
-                                if(cellsStartAddress < settings.interpreter.ramSize - 4)
-                                    cellsStartAddress += 4;
-                                else
-                                    cellsStartAddress = 4 - (settings.interpreter.ramSize - cellsStartAddress);
-                            }
-                            else {
-                                if(cellsStartAddress >= 4)
-                                    cellsStartAddress -= 4;
-                                else
-                                    cellsStartAddress = settings.interpreter.ramSize - (4 - cellsStartAddress);
-                            }
+                            //A row per tick, a page with shift
+                            viewer.scroll(((event.wheel.y < 0) ? 1 : -1) * (shiftPressed ? VIEWER_ROWS : 1));
                         break;
                     case SDL_KEYDOWN:
+                        //With ctrl the keys go to the memory viewer: hex digits jump, P and S follow PC and SP
+                        if(SDL_GetModState() & KMOD_CTRL) {
+                            refresh = true;
+                            if(code >= SDL_SCANCODE_1 && code <= SDL_SCANCODE_9)
+                                viewer.typeNibble(code - SDL_SCANCODE_1 + 1);
+                            else if(code == SDL_SCANCODE_0)
+                                viewer.typeNibble(0x0);
+                            else if(code >= SDL_SCANCODE_A && code <= SDL_SCANCODE_F)
+                                viewer.typeNibble(code - SDL_SCANCODE_A + 0xA);
+                            else if(code == SDL_SCANCODE_P)
+                                viewer.setFollow((viewer.getFollow() == VIEWER_FOLLOW_PC) ? VIEWER_FREE : VIEWER_FOLLOW_PC);
+                            else if(code == SDL_SCANCODE_S)
+                                viewer.setFollow((viewer.getFollow() == VIEWER_FOLLOW_SP) ? VIEWER_FREE : VIEWER_FOLLOW_SP);
+                            else if(code == SDL_SCANCODE_H) {
+                                //The accesses are only counted while the heatmap is shown
+                                heatmapShown = !heatmapShown;
+                                heatmap.clear();
+                                heatmap.render(heatmapPixels.data());
+                                window.updateTexture(heatmapTexture, heatmapPixels.data(), HEAT_SIDE * sizeof(Uint32));
+                                CM.setHeatmap(heatmapShown ? &heatmap : NULL);
+                                heatmapHot = false;
+                            }
+                            break;
+                        }
                         if(code >= SDL_SCANCODE_A && code <= SDL_SCANCODE_Z) {
                             key = code + 93;
                             if(shiftPressed) key -= 0x20;
@@ -319,15 +381,35 @@ int main(int argc, char* args[]) {
                         else if(!shiftPressed && (code == SDL_SCANCODE_LSHIFT || code == SDL_SCANCODE_RSHIFT))
                             shiftPressed = true;
                         IOD.input(key);
+                        recorder.record(SESSION_INPUT, key);
                         break;
                     case SDL_KEYUP:
                         if(shiftPressed && (code == SDL_SCANCODE_LSHIFT || code == SDL_SCANCODE_RSHIFT))
                             shiftPressed = false;
                         key = 0x0;
                         IOD.input(key);
+                        recorder.record(SESSION_INPUT, key);
                         break;
                 }
             }
+            //Hot reload, the CPU state is kept and only the changed bytes are patched
+            if(watcher.poll(programUpdate)) {
+                refresh = true;
+                if(!programUpdate.assembled) {
+                    for(const AssemblerDiagnostic& d : programUpdate.diagnostics)
+                        logger.log(LOG_ERROR, LOG_TEXT, settings.interpreter.file + ":" + to_string(d.line) + ": " + d.message);
+                }
+                else {
+                    vector<pair<Uint16, Uint16>> conflicts;
+                    Uint32 patched = CM.patchProgram(programUpdate.previous, programUpdate.next, conflicts);
+                    if(programUpdate.next.ramSize > settings.interpreter.ramSize)
+                        settings.interpreter.ramSize = programUpdate.next.ramSize;
+                    recorder.recordMemory(SESSION_PATCH, settings.interpreter);
+                    logger.log(LOG_INFO, LOG_HOT_RELOADED, settings.interpreter.file, patched);
+                    for(const pair<Uint16, Uint16>& c : conflicts)
+                        logger.log(LOG_WARNING, LOG_HOT_CONFLICT, settings.interpreter.file, c.first, c.second);
+                }
+            }
             //Actual processing
             SDL_GetMouseState(&cursorPosition.x, &cursorPosition.y);
             guiCursorPosition.x = (cursorPosition.x / settings.win.scale / window.getScale());
@@ -338,8 +420,11 @@ int main(int argc, char* args[]) {
                 else fastButton.changeNormal();
                 inHitboxes++;
                 if(clicked) {
+                    recorder.record(SESSION_FAST);
                     constantRefresh = true;
                     constantFullInstruction = true;
+                    clockStart = SDL_GetPerformanceCounter();
+                    cycles = 0;
                 }
             }
             if(guiCursorPosition == *playButton.getHitBox()) {
@@ -347,6 +432,7 @@ int main(int argc, char* args[]) {
                 else playButton.changeNormal();
                 inHitboxes++;
                 if(clicked) {
+                    recorder.record(SESSION_PLAY);
                     refresh = true;
                     fullInstruction = true;
                 }
@@ -356,6 +442,7 @@ int main(int argc, char* args[]) {
                 else nextButton.changeNormal();
                 inHitboxes++;
                 if(clicked) {
+                    recorder.record(SESSION_NEXT);
                     refresh = true;
                     switch(phaseNext) {
                         case 0:
@@ -378,6 +465,7 @@ int main(int argc, char* args[]) {
                 else pauseButton.changeNormal();
                 inHitboxes++;
                 if(clicked) {
+                    recorder.record(SESSION_PAUSE);
                     constantRefresh = false;
                     refresh = true;
                     constantFullInstruction = false;
@@ -396,7 +484,12 @@ int main(int argc, char* args[]) {
                     IOD.reset();
                     CM.loadProgram(&settings.interpreter, &logger);
                     CPU.reset(settings.interpreter);
-                    msStep = 1000 / settings.win.maxFps;
+                    recorder.recordMemory(SESSION_RELOAD, settings.interpreter);
+                    frameTicks = frequency / settings.win.maxFps;
+                    window.invalidateStaticLayer();
+                    watcher.stop();
+                    if(settings.interpreter.hotReload && !watcher.start(settings.interpreter))
+                        logger.log(LOG_WARNING, LOG_WATCH_FAILED, settings.interpreter.file);
                 }
             }
             if(inHitboxes > 0) {
@@ -409,56 +502,83 @@ int main(int argc, char* args[]) {
             }
             cursorEntity.setXY(cursorPosition.x, cursorPosition.y);
             cursorEntity.setCurrentFrame(cursor.pointers[cursorState]);
-            window.clear();
-            if(settings.win.fpsCounter) {
-                window.renderText(fpsCounterEntity);
-            }
-            
+
             instNameValue = CPU.getInstName();
             if(phaseNext >= 4) {
                 fullInstruction = false;
                 constantFullInstruction = false;
             }
             CPU.getPhases(phaseNow, phaseNext);
-            if(fullInstruction || constantFullInstruction) {
-                switch(phaseNext) {
-                    case 0: CPU.fetchInstruction();
-                    case 1: CPU.decodeInstruction();
-                    case 2: 
-                        CPU.getPhases(phaseNow, phaseNext);
-                        if(phaseNext == 2) CPU.fetchOperand();
-                    case 3: CPU.executeInstruction();
-                }
+            renderStart = SDL_GetPerformanceCounter();
+            if(fullInstruction) {
+                instructions += (CPU.step() > 0);
                 fullInstruction = false;
                 progressBarAll = true;
             }
+            else if(constantFullInstruction) {
+                //The governor gives the simulation what is left of the frame after the average render cost,
+                //the clock is read every 64 instructions
+                Uint64 deadline = frameStart + frameTicks - min(renderTicks, frameTicks), simStart = renderStart;
+                Uint64 target = ~Uint64(0);
+                Uint32 clock = settings.interpreter.clock;
+                if(clock > 0) {
+                    //With a clock the cycles due are counted from when it started, so there is no drift,
+                    //and the frame pacing sleeps until the wall clock catches up
+                    Uint64 elapsed = simStart - clockStart;
+                    target = elapsed / frequency * clock + elapsed % frequency * clock / frequency;
+                    //A stall is not recovered in a burst, at most a second of cycles is owed
+                    if(target > cycles + clock) cycles = target - clock;
+                }
+                Uint32 executed = 0;
+                while(cycles < target) {
+                    Uint8 c = CPU.step();
+                    if(c == 0) break;
+                    cycles += c;
+                    if(++executed % 64 == 0 && SDL_GetPerformanceCounter() >= deadline) break;
+                }
+                instructions += executed;
+                progressBarAll = true;
+                renderStart = SDL_GetPerformanceCounter();
+                simTicks += renderStart - simStart;
+            }
             if(refresh || constantRefresh) {
                 //CPU Values
-                pcValue = "0x" + math::Uint16ToHexstr(CPU.getPC());
-                irValue = "0x" + math::Uint16ToHexstr(CPU.getIR());
-                srValue = math::StatusRegisterToHexstr(CPU.getSR());
-                arValue = "0x" + math::Uint16ToHexstr(CPU.getAR());
-                drValue = "0x" + math::Uint16ToHexstr(CPU.getDR());
-                spValue = "0x" + math::Uint16ToHexstr(CPU.getSP());
+                //Only the registers that changed are written, in place in the fixed width slots, and highlighted
+                Uint32 changes = CPU.getChanges();
+                if(changes & CHANGED_PC) pcValue.setHex(2, CPU.getPC(), 4);
+                if(changes & CHANGED_IR) irValue.setHex(2, CPU.getIR(), 4);
+                if(changes & CHANGED_SR) {
+                    math::StatusRegisterToChars(CPU.getSR(), bits);
+                    srValue.setChars(0, bits, 4);
+                }
+                if(changes & CHANGED_AR) arValue.setHex(2, CPU.getAR(), 4);
+                if(changes & CHANGED_DR) drValue.setHex(2, CPU.getDR(), 4);
+                if(changes & CHANGED_SP) spValue.setHex(2, CPU.getSP(), 4);
+                pcValue.setHighlight(changes & CHANGED_PC);
+                irValue.setHighlight(changes & CHANGED_IR);
+                srValue.setHighlight(changes & CHANGED_SR);
+                arValue.setHighlight(changes & CHANGED_AR);
+                drValue.setHighlight(changes & CHANGED_DR);
+                spValue.setHighlight(changes & CHANGED_SP);
                 refresh = false;
+                redraw = true;
                 for(Uint8 i = 0; i < 16; i++) {
-                    registriesValues[i] = "0x" + math::Uint16ToHexstr(CPU.getR(i));
-                }
-                for(Uint16 i = 0, j = cellsStartAddress; i < 16; j++, i++) {
-                    if(j == settings.interpreter.ramSize) j = 0;
-                    cellTitles[i] = "0x" + math::Uint16ToHexstr(j) + ":";
-                    cellValues[i] = "0x" + math::Uint8ToHexstr(CM.get(j));
+                    if(changes & CHANGED_R(i)) registriesValues[i].setHex(2, CPU.getR(i), 4);
+                    registriesValues[i].setHighlight(changes & CHANGED_R(i));
                 }
+                viewer.update(&CM, &CPU, settings.interpreter.ramSize);
+                followValue.setChars(0, (viewer.getFollow() == VIEWER_FOLLOW_PC) ? "PC" :
+                    ((viewer.getFollow() == VIEWER_FOLLOW_SP) ? "SP" : "  "), 2);
                 CPU.getPhases(phaseNow, phaseNext);
-                string l0, l1, l2, l3;
                 IOD.getLines(l0, l1, l2, l3);
                 monitorLine0 = l0;
                 monitorLine1 = l1;
                 monitorLine2 = l2;
                 monitorLine3 = l3;
-                abValue = "0x" + math::Uint16ToHexstr(SB.getAddress());
-                dbValue = "0x" + math::Uint16ToHexstr(SB.getData());
-                cbValue = math::ControlBusToHexstr(SB.getControl());
+                abValue.setHex(2, SB.getAddress(), 4);
+                dbValue.setHex(2, SB.getData(), 4);
+                math::ControlBusToChars(SB.getControl(), bits);
+                cbValue.setChars(0, bits, 3);
                 progressBarNowEntity.setX(117 + 8 * phaseNow);
                 progressBarNextEntity.setX(117 + 8 * phaseNext);
             }
@@ -503,59 +623,97 @@ int main(int argc, char* args[]) {
                     case 'm': case 'M': indexKey = 35; break;
                 }
                 for(Uint8 i = 0; i < 36; i++) {
-                    iodKeyEntities[i].setTexture(((i == indexKey) ? iodKeyPressedTexture : iodKeyTexture));
+                    iodKeyEntities[i].setCurrentFrame((i == indexKey) ? keyPressedFrame : keyFrame);
                 }
             }
             else {
                 for(Entity &e : iodKeyEntities) {
-                    e.setTexture(iodKeyTexture);
+                    e.setCurrentFrame(keyFrame);
                 }
             }
-            //GUI backgrounds
-            window.renderGui(cpuGui);
-            window.renderGui(cmGui);
-            window.renderGui(iodGui);
-            window.renderGui(sbGui);
+            //The counters fade every frame, the texture is uploaded once per frame while something is hot
+            if(heatmapShown) {
+                heatmapHot = heatmap.decay();
+                if(heatmapHot) {
+                    heatmap.render(heatmapPixels.data());
+                    window.updateTexture(heatmapTexture, heatmapPixels.data(), HEAT_SIDE * sizeof(Uint32));
+                    redraw = true;
+                }
+            }
+            if(!redraw) continue;
+            redraw = false;
+            window.clear();
+            //Static layer, drawn only when the window changes
+            if(window.beginStaticLayer()) {
+                //GUI backgrounds
+                window.renderGui(cpuGui);
+                window.renderGui(cmGui);
+                window.renderGui(iodGui);
+                window.renderGui(sbGui);
+                //CPU
+                window.renderText(cpuTitle);
+                window.renderText(cuTitle);
+                window.renderText(aluTitle);
+                window.renderText(pcTitle);
+                window.renderText(irTitle);
+                window.renderText(srTitle);
+                window.renderText(srElements);
+                window.renderText(arTitle);
+                window.renderText(drTitle);
+                window.renderText(spTitle);
+                for(TextEntity &e : registriesTitles) {
+                    window.renderText(e);
+                }
+                //CM
+                window.renderText(cmTitle);
+                window.renderText(ramTitle);
+                //IOD
+                window.renderText(iodTitle);
+                window.renderText(monitorTitle);
+                window.renderText(keyboardTitle);
+                //SB
+                window.renderText(abTitle);
+                window.renderText(dbTitle);
+                window.renderText(cbTitle);
+                //Instruction name
+                window.renderText(instNameTitle);
+                //Progress bar
+                window.renderText(progressBarIfTitle);
+                window.renderText(progressBarIdTitle);
+                window.renderText(progressBarOfTitle);
+                window.renderText(progressBarIeTitle);
+                window.renderGui(progressBarEntity);
+                //Icon
+                window.renderGui(iconEntity);
+                window.renderText(creditsText0);
+                window.renderText(creditsText1);
+                window.renderText(creditsText2);
+            }
+            window.endStaticLayer();
+            if(settings.win.fpsCounter) {
+                window.renderText(fpsCounterEntity);
+                window.renderText(statsEntity);
+            }
             //CPU Render
-            window.renderText(cpuTitle);
-            window.renderText(cuTitle);
-            window.renderText(aluTitle);
-            window.renderText(pcTitle);
-            window.renderText(irTitle);
-            window.renderText(srTitle);
-            window.renderText(srElements);
-            window.renderText(arTitle);
-            window.renderText(drTitle);
-            window.renderText(spTitle);
             window.renderText(pcValue);
             window.renderText(irValue);
             window.renderText(srValue);
             window.renderText(arValue);
             window.renderText(drValue);
             window.renderText(spValue);
-            for(TextEntity &e : registriesTitles) {
-                window.renderText(e);
-            }
             for(TextEntity &e : registriesValues) {
                 window.renderText(e);
             }
             //CM Render
-            window.renderText(cmTitle);
-            window.renderText(ramTitle);
-            for(TextEntity &e : cellTitles) {
-                window.renderText(e);
-            }
-            for(TextEntity &e : cellValues) {
+            window.renderText(followValue);
+            for(TextEntity &e : viewer.getRows()) {
                 window.renderText(e);
             }
             //IOD Render
-            window.renderText(iodTitle);
-            window.renderText(monitorTitle);
             window.renderText(monitorLine0);
             window.renderText(monitorLine1);
             window.renderText(monitorLine2);
             window.renderText(monitorLine3);
-            window.renderText(keyboardTitle);
             for(Entity &e : iodKeyEntities) {
                 window.renderGui(e);
             }
@@ -563,21 +721,12 @@ int main(int argc, char* args[]) {
                 window.renderText(e);
             }
             //SB Render
-            window.renderText(abTitle);
-            window.renderText(dbTitle);
-            window.renderText(cbTitle);
             window.renderText(abValue);
             window.renderText(dbValue);
             window.renderText(cbValue);
             //Instruction name
-            window.renderText(instNameTitle);
             window.renderText(instNameValue);
             //Progress bar
-            window.renderText(progressBarIfTitle);
-            window.renderText(progressBarIdTitle);
-            window.renderText(progressBarOfTitle);
-            window.renderText(progressBarIeTitle);
-            window.renderGui(progressBarEntity);
             if(phaseNow < 4 && !progressBarAll) {
                 window.renderGui(progressBarNowEntity);
             }
@@ -593,13 +742,14 @@ int main(int argc, char* args[]) {
             window.renderButton(nextButton);
             window.renderButton(pauseButton);
             window.renderButton(reloadButton);
-            //Icon
-            window.renderGui(iconEntity);
-            window.renderText(creditsText0);
-            window.renderText(creditsText1);
-            window.renderText(creditsText2);
+            //Heatmap, over the CPU and the CM
+            if(heatmapShown) window.renderGui(heatmapEntity);
             //Display
             window.renderCursor(cursorEntity);
+            //The presentation is not counted, with vsync it waits for the screen
+            now = SDL_GetPerformanceCounter();
+            renderTicks = (renderTicks * 7 + (now - renderStart)) / 8;
+            workTicks += now - frameStart;
             window.display();
         }
     }
@@ -114,12 +114,16 @@ string math::Uint16ToHexstr(Uint16 n) {
 
 string math::StatusRegisterToHexstr(StatusRegister sr) {
     char s[5];
+    StatusRegisterToChars(sr, s);
+    s[4] = '\0';
+    return s;
+}
+
+void math::StatusRegisterToChars(StatusRegister sr, char* s) {
     s[0] = ((sr.Z) ? '1' : '0');
     s[1] = ((sr.N) ? '1' : '0');
     s[2] = ((sr.C) ? '1' : '0');
     s[3] = ((sr.V) ? '1' : '0');
-    s[4] = '\0';
-    return s;
 }
 
 Uint16 math::twosComplement(Uint16 n) {
@@ -154,29 +158,29 @@ Uint16 math::twosComplement(Uint16 n) {
 
 string math::ControlBusToHexstr(ControlBus cb) {
     char s[4];
-    s[0] = (cb.M ? 'M' : 'D');
-    s[1] = (cb.R ? 'R' : 'W');
-    s[2] = (cb.W ? 'W' : 'B');
+    ControlBusToChars(cb, s);
     s[3] = '\0';
     return s;
 }
 
-string math::argumentToRegister(string arg) {
-    if(arg.length() != 2 || arg[0] != 'R') throw(1);
-    return arg.substr(1, 1);
+void math::ControlBusToChars(ControlBus cb, char* s) {
+    s[0] = (cb.M ? 'M' : 'D');
+    s[1] = (cb.R ? 'R' : 'W');
+    s[2] = (cb.W ? 'W' : 'B');
 }
 
-vector<string> math::wordToLittleEndian(string w) {
-    if(w.length() != 4) throw(2);
-    vector<string> v;
-    v.push_back(w.substr(2, 2));
-    v.push_back(w.substr(0, 2));
-    return v;
+Uint64 math::hash(const void* data, size_t length, Uint64 h) {
+    const Uint8* p = (const Uint8*)data;
+    for(size_t i = 0; i < length; i++) {
+        h ^= p[i];
+        h *= 0x100000001B3;
+    }
+    return h;
 }
 
-bool math::vectorContains(vector<string> v, string s) {
-    for(string e : v) {
-        if(e == s) return true;
-    }
-    return false;
-}
\ No newline at end of file
+Uint64 math::mix(Uint64 x) {
+    x += 0x9E3779B97F4A7C15;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+    return x ^ (x >> 31);
+}
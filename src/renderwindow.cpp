@@ -7,26 +7,26 @@
 using namespace std;
 
 RenderWindow::RenderWindow(const char* title, int width, int height, Uint32 flags, Logger* plogger, Settings* psettings, const char* icon)
-    :window(NULL), renderer(NULL), logger(plogger), settings(psettings) {
+    :window(NULL), renderer(NULL), logger(plogger), settings(psettings), textTexture(NULL),
+    staticLayer(NULL), staticLayerValid(false), staticLayerDrawing(false), staticLayerWidth(0), staticLayerHeight(0),
+    staticLayerScale(0), staticLayerSettingsScale(0) {
     //Initializing the window
     window = SDL_CreateWindow(title, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height,
         SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE | SDL_WINDOW_ALLOW_HIGHDPI | SDL_WINDOW_OPENGL);
     //Check for errors
-    cout << logger->getStringTime();
     if(window == NULL) {
-        cout << logger->error << "Window Initialization FAILED! SDL_ERROR: " << SDL_GetError() << logger->reset << endl;
+        logger->log(LOG_ERROR, LOG_WINDOW_FAILED, SDL_GetError());
     }
     else {
-        cout << logger->success << "Window Initialized Succesfully" << logger->reset << endl;
+        logger->log(LOG_SUCCESS, LOG_WINDOW);
     }
     SDL_Surface* iconSurface = NULL;
     iconSurface = IMG_Load(icon);
-    cout << logger->getStringTime();
     if(iconSurface == NULL) {
-        cout << logger->warning << "Icon Loading FAILED! SDL_ERROR: " << SDL_GetError() << logger->reset << endl;
+        logger->log(LOG_WARNING, LOG_ICON_FAILED, SDL_GetError());
     }
     else {
-        cout << logger->success << "Icon " << icon << " Loaded Succesfully" << logger->reset << endl;
+        logger->log(LOG_SUCCESS, LOG_ICON, icon);
     }
     SDL_SetWindowIcon(window, iconSurface);
     //Initializing the Renderer
@@ -39,40 +39,129 @@ SDL_Texture* RenderWindow::loadTexture(const char* filePath) {
     SDL_Texture* texture = NULL;
     //Check for errors
     texture = IMG_LoadTexture(renderer, filePath);
-    cout << logger->getStringTime();
     if(texture == NULL) {
-        cout << logger->warning << "Texture Loading FAILED! SDL_ERROR: " << SDL_GetError() << logger->reset << endl;
+        logger->log(LOG_WARNING, LOG_TEXTURE_FAILED, SDL_GetError());
     }
     else {
-        cout << logger->success << "Texture " << filePath << " Loaded Succesfully" << logger->reset << endl;
+        logger->log(LOG_SUCCESS, LOG_TEXTURE, filePath);
     }
     return texture;
 }
 
+SDL_Texture* RenderWindow::loadTexture(SDL_Surface* surface, const char* name) {
+    SDL_Texture* texture = (surface == NULL) ? NULL : SDL_CreateTextureFromSurface(renderer, surface);
+    if(texture == NULL) {
+        logger->log(LOG_WARNING, LOG_TEXTURE_FAILED, SDL_GetError());
+    }
+    else {
+        logger->log(LOG_SUCCESS, LOG_TEXTURE, name);
+    }
+    return texture;
+}
+
+SDL_Texture* RenderWindow::createStreamingTexture(int width, int height, const char* name) {
+    SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                             width, height);
+    if(texture == NULL) {
+        logger->log(LOG_WARNING, LOG_TEXTURE_FAILED, SDL_GetError());
+    }
+    else {
+        logger->log(LOG_SUCCESS, LOG_TEXTURE, name);
+    }
+    return texture;
+}
+
+void RenderWindow::updateTexture(SDL_Texture* texture, const void* pixels, int pitch) {
+    if(texture != NULL) SDL_UpdateTexture(texture, NULL, pixels, pitch);
+}
+
 void RenderWindow::clear() {
     SDL_RenderClear(renderer);
 }
 
-void RenderWindow::renderGui(Entity& entity) {
-    SDL_Rect src;
-    src.x = entity.getCurrentFrame().x;
-    src.y = entity.getCurrentFrame().y;
-    src.w = entity.getCurrentFrame().w;
-    src.h = entity.getCurrentFrame().h;
-    SDL_Rect dst;
-    dst.x = entity.getPos().x * settings->win.scale * scale;
-    dst.y = entity.getPos().y * settings->win.scale * scale;
-    dst.w = entity.getCurrentFrame().w * settings->win.scale * ((float)scale / 2);
-    dst.h = entity.getCurrentFrame().h * settings->win.scale * ((float)scale / 2);
+bool RenderWindow::beginStaticLayer() {
+    int w, h;
+    SDL_GetRendererOutputSize(renderer, &w, &h);
+    if(staticLayerValid && w == staticLayerWidth && h == staticLayerHeight && scale == staticLayerScale
+        && settings->win.scale == staticLayerSettingsScale) return false;
+    flushText();
+    staticLayerValid = false;
+    if(!SDL_RenderTargetSupported(renderer)) return true;
+    if(staticLayer == NULL || w != staticLayerWidth || h != staticLayerHeight) {
+        if(staticLayer != NULL) SDL_DestroyTexture(staticLayer);
+        staticLayer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
+        if(staticLayer == NULL) return true;
+        SDL_SetTextureBlendMode(staticLayer, SDL_BLENDMODE_NONE);
+    }
+    if(SDL_SetRenderTarget(renderer, staticLayer) != 0) return true;
+    staticLayerWidth = w;
+    staticLayerHeight = h;
+    staticLayerScale = scale;
+    staticLayerSettingsScale = settings->win.scale;
+    staticLayerDrawing = true;
+    SDL_RenderClear(renderer);
+    return true;
+}
+
+void RenderWindow::endStaticLayer() {
+    if(staticLayerDrawing) {
+        flushText();
+        SDL_SetRenderTarget(renderer, NULL);
+        staticLayerDrawing = false;
+        staticLayerValid = true;
+    }
+    //The layer is opaque and covers the whole window
+    if(staticLayerValid) SDL_RenderCopy(renderer, staticLayer, NULL, NULL);
+}
 
+void RenderWindow::invalidateStaticLayer() {
+    staticLayerValid = false;
+}
+
+void RenderWindow::renderGui(Entity& entity) {
+    SDL_Rect src = entity.getCurrentFrame(), dst;
+    calculateDestination(entity.getPos(), src, dst);
+    flushText();
     SDL_RenderCopy(renderer, entity.getTexture(), &src, &dst);
 }
 
 void RenderWindow::renderText(TextEntity& textEntity) {
-    vector<Entity>* p = textEntity.getTextEntity();
-    for(Entity& e : *p) {
-        renderGui(e);
+    const char* glyphs = textEntity.getGlyphs();
+    Uint8 length = textEntity.getLength();
+    Font* font = textEntity.getFont();
+    SDL_Texture* texture = textEntity.getTexture();
+    Vector2f pos = textEntity.getPos();
+    SDL_Color color = textEntity.getColor();
+    SDL_Rect src, dst;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if(texture != textTexture) {
+        flushText();
+        textTexture = texture;
     }
+#else
+    bool tinted = color.r != 255 || color.g != 255 || color.b != 255;
+    if(tinted) SDL_SetTextureColorMod(texture, color.r, color.g, color.b);
+#endif
+    for(Uint8 i = 0; i < length; i++) {
+        //Every glyph is 3 units wide
+        src = font->letters[Uint8(glyphs[i]) & 0x7F];
+        calculateDestination(Vector2f(pos.x + (i * 3), pos.y), src, dst);
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+        //Two triangles per glyph, texture coordinates are normalized when the batch is flushed
+        int first = textVertices.size();
+        textVertices.push_back({{float(dst.x), float(dst.y)}, color, {float(src.x), float(src.y)}});
+        textVertices.push_back({{float(dst.x + dst.w), float(dst.y)}, color, {float(src.x + src.w), float(src.y)}});
+        textVertices.push_back({{float(dst.x + dst.w), float(dst.y + dst.h)}, color, {float(src.x + src.w), float(src.y + src.h)}});
+        textVertices.push_back({{float(dst.x), float(dst.y + dst.h)}, color, {float(src.x), float(src.y + src.h)}});
+        textIndices.insert(textIndices.end(), {first, first + 1, first + 2, first, first + 2, first + 3});
+#else
+        SDL_RenderCopy(renderer, texture, &src, &dst);
+#endif
+    }
+#if !SDL_VERSION_ATLEAST(2, 0, 18)
+    //The font shares the atlas texture, the GUI drawn after the text must not be tinted
+    if(tinted) SDL_SetTextureColorMod(texture, 255, 255, 255);
+#endif
 }
 
 void RenderWindow::renderButton(Button& button) {
@@ -87,6 +176,7 @@ void RenderWindow::renderButton(Button& button) {
     dst.w = button.getCurrentFrame().w * settings->win.scale * ((float)scale / 2);
     dst.h = button.getCurrentFrame().h * settings->win.scale * ((float)scale / 2);
 
+    flushText();
     SDL_RenderCopy(renderer, button.getTexture(), &src, &dst);
 }
 
@@ -102,14 +192,18 @@ void RenderWindow::renderCursor(Entity& entity) {
     dst.w = entity.getCurrentFrame().w * settings->win.scale * ((float)scale / 2);
     dst.h = entity.getCurrentFrame().h * settings->win.scale * ((float)scale / 2);
 
+    flushText();
     SDL_RenderCopy(renderer, entity.getTexture(), &src, &dst);
 }
 
 void RenderWindow::display() {
+    flushText();
     SDL_RenderPresent(renderer);
 }
 
 void RenderWindow::cleanUp() {
+    if(staticLayer != NULL) SDL_DestroyTexture(staticLayer);
+    staticLayer = NULL;
     SDL_DestroyWindow(window);
 }
 
@@ -122,4 +216,28 @@ void RenderWindow::calculateScale() {
 
 Uint8 RenderWindow::getScale() {
     return scale;
+}
+
+void RenderWindow::calculateDestination(Vector2f pos, SDL_Rect frame, SDL_Rect& dst) {
+    dst.x = pos.x * settings->win.scale * scale;
+    dst.y = pos.y * settings->win.scale * scale;
+    dst.w = frame.w * settings->win.scale * ((float)scale / 2);
+    dst.h = frame.h * settings->win.scale * ((float)scale / 2);
+}
+
+void RenderWindow::flushText() {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if(textIndices.empty()) return;
+    int w, h;
+    if(SDL_QueryTexture(textTexture, NULL, NULL, &w, &h) == 0 && w > 0 && h > 0) {
+        for(SDL_Vertex& v : textVertices) {
+            v.tex_coord.x /= w;
+            v.tex_coord.y /= h;
+        }
+        SDL_RenderGeometry(renderer, textTexture, textVertices.data(), textVertices.size(),
+                           textIndices.data(), textIndices.size());
+    }
+    textVertices.clear();
+    textIndices.clear();
+#endif
 }
\ No newline at end of file
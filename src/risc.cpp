@@ -1,4 +1,13 @@
+#include <cstring>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 #include "risc.hpp"
+#include "image.hpp"
+#include "assembler.hpp"
 
 using namespace std;
 
@@ -93,7 +102,6 @@ void ArithmeticLogicUnit::sub(Uint8 d, Uint8 s) {
     Int16 a = Int16(R[d]), b = Int16(R[s]);
     Int32 res = a - b, resc = R[d] + math::twosComplement(R[s]);
     R[d] -= R[s];
-    cout << "res: " << res << "R[d]" << R[d] << endl;
     SR->C = (resc > 0xFFFF);
     SR->V = (Int16(R[d]) != res);
     SR->N = (res < 0x0);
@@ -185,9 +193,15 @@ Uint16 ArithmeticLogicUnit::get(Uint8 r) {
     return R[r];
 }
 
+void ArithmeticLogicUnit::restore(const ArithmeticLogicUnit& snapshot) {
+    memcpy(R, snapshot.R, sizeof(R));
+}
+
 CentralProcessingUnit::CentralProcessingUnit(SystemBus* pSB, CentralMemory* pCM, InputOutputDevices* pIOD)
     :ALU(ArithmeticLogicUnit(&SR)), SB(pSB), CM(pCM), IOD(pIOD), PC(0), phaseNow(0xFF), phaseNext(0x0), instName("-----"),
-    SP(0), IR(0x0), AR(0x0), DR(0x0) {}
+    SP(0), IR(0x0), AR(0x0), DR(0x0), retired(0) {
+    memset(seen, 0, sizeof(seen));
+}
 
 void CentralProcessingUnit::reset(InterpreterSettings settings) {
     PC = settings.start;
@@ -202,19 +216,25 @@ void CentralProcessingUnit::reset(InterpreterSettings settings) {
     SR.N = false;
     SR.C = false;
     SR.V = false;
+    retired = 0;
 }
 
 void CentralProcessingUnit::fetchInstruction() {
     AR = PC;
     SB->writeAddress(AR);
     SB->writeControl(ControlBus(READ, MEMORY, WORD));
-    CM->operate();
+    CM->fetch();
     IR = SB->getData();
     PC += 2;
     instName = "-----";
     phaseNow = 0, phaseNext = 1;
 }
 
+void CentralProcessingUnit::setIR(Uint16 instruction) {
+    IR = instruction;
+    phaseNow = 0, phaseNext = 1;
+}
+
 void CentralProcessingUnit::decodeInstruction() {
     SB->cleanAddress();
     SB->cleanData();
@@ -244,20 +264,20 @@ void CentralProcessingUnit::fetchOperand() {
             AR = PC;
             SB->writeAddress(AR);
             SB->writeControl(ControlBus(READ, MEMORY, WORD));
-            CM->operate();
+            CM->fetch();
             break;
         case 0x1: //LD$I
             AR = PC;
             SB->writeAddress(AR);
-            SB->writeControl(ControlBus(READ, MEMORY, (I.opcode & 0x0F00 == 0x0000) ? WORD : BYTE));
-            CM->operate();
+            SB->writeControl(ControlBus(READ, MEMORY, (I.opcode == 0x0) ? WORD : BYTE));
+            CM->fetch();
             break;
         case 0x2: //$$$A
             if(I.opcode == 0x0 || I.opcode == 0x1) { //LD$A
                 AR = PC;
                 SB->writeAddress(AR);
                 SB->writeControl(ControlBus(READ, MEMORY, WORD));
-                CM->operate();
+                CM->fetch();
                 AR = SB->getData();
                 SB->writeAddress(AR);
                 SB->writeControl(ControlBus(READ, MEMORY, WORD));
@@ -267,22 +287,35 @@ void CentralProcessingUnit::fetchOperand() {
                 AR = PC;
                 SB->writeAddress(AR);
                 SB->writeControl(ControlBus(READ, MEMORY, WORD));
-                CM->operate();
+                CM->fetch();
             }
             break;
         case 0x3: //LD$R
             AR = ALU.get(I.rb);
             SB->writeAddress(AR);
-            SB->writeControl(ControlBus(READ, MEMORY, (I.opcode & 0x0F00 == 0x0000) ? WORD : BYTE));
+            SB->writeControl(ControlBus(READ, MEMORY, (I.opcode == 0x0) ? WORD : BYTE));
             CM->operate();
     }
     phaseNow = 2;
     phaseNext = 3;
 }
 
+Uint8 CentralProcessingUnit::step() {
+    Uint8 cycles = 0;
+    switch(phaseNext) {
+        case 0: fetchInstruction(); cycles++;
+        case 1: decodeInstruction(); cycles++;
+            if(phaseNext > 3) return cycles; //Rejected by the decoder, like the next button it is not executed
+        case 2: if(phaseNext == 2) { fetchOperand(); cycles++; }
+        case 3: executeInstruction(); cycles++;
+    }
+    return cycles;
+}
+
 void CentralProcessingUnit::executeInstruction() {
     phaseNow = 3;
     phaseNext = 0;
+    retired++;
     switch(I.group) {
         case 0x0: //Data transfer group
             switch(I.addressing) {
@@ -484,7 +517,7 @@ Uint16 CentralProcessingUnit::getSP() {
     return SP;
 }
 
-string CentralProcessingUnit::getInstName() {
+const string& CentralProcessingUnit::getInstName() {
     return instName;
 }
 
@@ -498,6 +531,85 @@ void CentralProcessingUnit::getPhases(Uint8 &now, Uint8 &next) {
     return;
 }
 
+Uint32 CentralProcessingUnit::getChanges() {
+    //The values are compared with the previous call instead of marking every write, so no write can be missed
+    Uint16 now[CPU_REGISTERS];
+    for(Uint8 r = 0; r <= 0xF; r++)
+        now[r] = ALU.get(r);
+    now[16] = PC;
+    now[17] = IR;
+    now[18] = (SR.Z << 3) | (SR.N << 2) | (SR.C << 1) | SR.V;
+    now[19] = AR;
+    now[20] = DR;
+    now[21] = SP;
+    Uint32 changes = 0;
+    for(Uint8 i = 0; i < CPU_REGISTERS; i++) {
+        if(now[i] != seen[i]) changes |= 1 << i;
+        seen[i] = now[i];
+    }
+    return changes;
+}
+
+Uint64 CentralProcessingUnit::getRetired() {
+    return retired;
+}
+
+Uint16 CentralProcessingUnit::getRegister(Uint8 index) {
+    if(index <= 0xF) return ALU.get(index);
+    switch(index) {
+        case 16: return PC;
+        case 17: return IR;
+        case 18: return (SR.Z << 3) | (SR.N << 2) | (SR.C << 1) | SR.V;
+        case 19: return AR;
+        case 20: return DR;
+        case 21: return SP;
+    }
+    return 0;
+}
+
+void CentralProcessingUnit::setRegister(Uint8 index, Uint16 value) {
+    if(index <= 0xF) ALU.load(index, value);
+    switch(index) {
+        case 16: PC = value; break;
+        case 17: IR = value; break;
+        case 18:
+            SR.Z = value & 0x8;
+            SR.N = value & 0x4;
+            SR.C = value & 0x2;
+            SR.V = value & 0x1;
+            break;
+        case 19: AR = value; break;
+        case 20: DR = value; break;
+        case 21: SP = value; break;
+    }
+}
+
+Uint64 CentralProcessingUnit::getHash() {
+    Uint16 state[20];
+    for(Uint8 r = 0; r <= 0xF; r++)
+        state[r] = ALU.get(r);
+    state[16] = PC;
+    state[17] = SP;
+    state[18] = (SR.Z << 3) | (SR.N << 2) | (SR.C << 1) | SR.V;
+    state[19] = (phaseNext > 3) ? phaseNext : 0;
+    return math::hash(state, sizeof(state));
+}
+
+void CentralProcessingUnit::restore(const CentralProcessingUnit& snapshot) {
+    PC = snapshot.PC;
+    SP = snapshot.SP;
+    IR = snapshot.IR;
+    AR = snapshot.AR;
+    DR = snapshot.DR;
+    SR = snapshot.SR;
+    I = snapshot.I;
+    ALU.restore(snapshot.ALU);
+    phaseNow = snapshot.phaseNow;
+    phaseNext = snapshot.phaseNext;
+    instName = snapshot.instName;
+    retired = snapshot.retired;
+}
+
 string CentralProcessingUnit::decodeInstName() {
     switch(I.group) {
         case 0x0: //Data transfer group
@@ -855,20 +967,34 @@ void CentralProcessingUnit::hlt() {
     phaseNext = 0xF0;
 }
 
-CentralMemory::CentralMemory(SystemBus* pSB) :SB(pSB), size(0) {}
+/**
+ * @brief Function to get the hash of a cell, zero cells hash to 0 so a cleared memory hashes to 0
+ * @param address The cell address, type Uint32
+ * @param value The cell value, type Uint8
+ * @returns The hash, type Uint64
+*/
+static inline Uint64 cellHash(Uint32 address, Uint8 value) {
+    return (value == 0) ? 0 : math::mix((Uint64(address) << 8) | value);
+}
+
+CentralMemory::CentralMemory(SystemBus* pSB) :sink(OPEN_BUS), size(0), generation(0), hash(0), SB(pSB), heatmap(NULL) {
+    memset(lineVersions, 0, sizeof(lineVersions));
+    reset(0);
+}
 
 void CentralMemory::reset(Uint32 psize) {
-    size = psize;
-    M.clear();
-    for(Uint32 i = 0; i < size; i++) {
-        M.push_back(0x00);
-    }
+    size = min(psize, Uint32(MEMORY_SIZE));
+    memset(M, 0x00, size);
+    memset(M + size, OPEN_BUS, MEMORY_SIZE + 1 - size);
+    M[MEMORY_SIZE] = M[0];
+    hash = 0;
+    generation++;
 }
 
 void CentralMemory::loadProgram(InterpreterSettings* settings, Logger* logger) {
     ifstream file("binaries/" + settings->file);
     if(!file) {
-        cout << logger->warning << "File " << settings->file << " does not exist!" << logger->reset << endl;
+        logger->log(LOG_WARNING, LOG_FILE_MISSING, settings->file);
         return;        
     }
     char s[100];
@@ -877,313 +1003,59 @@ void CentralMemory::loadProgram(InterpreterSettings* settings, Logger* logger) {
             reset(settings->ramSize);
             for(Uint32 i = 0; i < size && !file.eof(); i++) {
                 file.getline(s, 100);
-                M[i] = math::binstrToUint8(s);
+                set(i, math::binstrToUint8(s));
             }
+            M[MEMORY_SIZE] = M[0];
             break;
         case 1:
             reset(settings->ramSize);
             for(Uint32 i = 0; i < size && !file.eof(); i++) {
                 file.getline(s, 100);
-                M[i] = math::hexstrToUint8(s);
+                set(i, math::hexstrToUint8(s));
             }
+            M[MEMORY_SIZE] = M[0];
             break;
+        case 3:
+            file.close();
+            if(!ImageFile::load("binaries/" + settings->file, this, settings, logger))
+                logger->log(LOG_ERROR, LOG_IMAGE_FAILED, settings->file);
+            return;
         default:
-            try {
-                cout << logger->getStringTime() << logger->warning << "Assembling file into hex executable"
-                    << logger->reset << endl;
-                ofstream outFile("binaries/" + settings->file + ".hex");
-                vector<string> asmLines;
-                while(!file.eof()) {
-                    file.getline(s, 100);
-                    string line = s;
-                    int commentPos = line.find(';');
-                    if(commentPos != string::npos) {
-                        line = line.substr(0, commentPos);
-                    }
-                    Int8 i = 0;
-                    while(i < line.length() && line[i] == ' ') {
-                        i++;
-                    }
-                    line = line.substr(i);
-                    i = line.length() - 1;
-                    while(i >= 0 && line[i] == ' ') {
-                        i--;
-                    }
-                    line = line.substr(0, i + 1);
-                    if(line.length() == 0) continue;
-                    asmLines.push_back(line);
-                }
-                vector<string> labels;
-                for(string l : asmLines) {
-                    int labelPos = l.find(':');
-                    if(labelPos != string::npos) labels.push_back(l.substr(0, labelPos));
-                }
-                vector<string> hexLines;
-                for(string l : asmLines) {
-                    int labelPos = l.find(':');
-                    string label = "";
-                    if(labelPos != string::npos) {
-                        label = l.substr(0, labelPos + 1);
-                        l = l.substr(labelPos + 1);
-                        Int8 i = 0;
-                        while(i < l.length() && l[i] == ' ') {
-                            i++;
-                        }
-                        l = l.substr(i);
-                    }
-                    string inst, arg1 = "", arg2 = "";
-                    int spacePos = l.find(' ');
-                    if(spacePos != string::npos) {
-                        inst = l.substr(0, spacePos);
-                        l = l.substr(spacePos + 1);
-                    }
-                    else inst = l;
-                    spacePos = l.find(' ');
-                    if(spacePos != string::npos) {
-                        arg1 = l.substr(0, spacePos);
-                        l = l.substr(spacePos);
-                    }
-                    else arg1 = l;
-                    spacePos = l.find(' ');
-                    if(spacePos != string::npos) {
-                        arg2 = l.substr(spacePos + 1);
-                    }
-                    if(inst.substr(0, 2) == "LD" && inst.length() == 4) {
-                        switch(inst[3]) {
-                            case 'I': //LDWI or LDBI
-                                hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                                if(inst[2] == 'W') {
-                                    hexLines.push_back("10");
-                                    for(string le : math::wordToLittleEndian(arg2))
-                                        hexLines.push_back(le);
-                                }
-                                else {
-                                    hexLines.push_back("11");
-                                    hexLines.push_back(arg2);
-                                }
-                                break;
-                            case 'A': //LDWA or LDBA
-                                hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                                if(inst[2] == 'W') hexLines.push_back("20");
-                                else hexLines.push_back("21");
-                                if(!math::vectorContains(labels, arg2))
-                                    for(string le : math::wordToLittleEndian(arg2))
-                                        hexLines.push_back(le);
-                                else
-                                    hexLines.push_back(arg2); hexLines.push_back("");
-                                break;
-                            case 'R': //LDWR or LDBR
-                                hexLines.push_back(label + math::argumentToRegister(arg1) + math::argumentToRegister(arg2));
-                                if(inst[2] == 'W') hexLines.push_back("30");
-                                else hexLines.push_back("31");
-                        }
-                    }
-                    else if(inst.substr(0, 2) == "ST" && inst.length() == 4) {
-                        switch(inst[3]) {
-                            case 'A': //STWA or STBA
-                                hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                                if(inst[2] == 'W') hexLines.push_back("22");
-                                else hexLines.push_back("23");
-                                if(!math::vectorContains(labels, arg2))
-                                    for(string le : math::wordToLittleEndian(arg2))
-                                        hexLines.push_back(le);
-                                else
-                                    hexLines.push_back(arg2); hexLines.push_back("");
-                                break;
-                            case 'R': //STWR or STBR
-                                hexLines.push_back(label + math::argumentToRegister(arg1) + math::argumentToRegister(arg2));
-                                if(inst[2] == 'W') hexLines.push_back("32");
-                                else hexLines.push_back("33");
-                        }
-                    }
-                    else if(inst == "CP" || inst == "MV") { //CP
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + math::argumentToRegister(arg2));
-                        hexLines.push_back("04");
-                    }
-                    else if(inst == "PUSH") { //PUSH
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                        hexLines.push_back("08");
-                    }
-                    else if(inst == "POP") { //POP
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                        hexLines.push_back("09");
-                    }
-                    else if(inst == "SPWR") { //SPWR
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                        hexLines.push_back("0D");
-                    }
-                    else if(inst == "SPRD") { //SPRD
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                        hexLines.push_back("0E");
-                    }
-                    else if(inst == "ADD") { //ADD
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + math::argumentToRegister(arg2));
-                        hexLines.push_back("40");
-                    }
-                    else if(inst == "SUB") { //SUB
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + math::argumentToRegister(arg2));
-                        hexLines.push_back("41");
-                    }
-                    else if(inst == "NOT") { //NOT
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                        hexLines.push_back("42");
-                    }
-                    else if(inst == "AND") { //AND
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + math::argumentToRegister(arg2));
-                        hexLines.push_back("43");
-                    }
-                    else if(inst == "OR") { //OR
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + math::argumentToRegister(arg2));
-                        hexLines.push_back("44");
-                    }
-                    else if(inst == "XOR") { //XOR
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + math::argumentToRegister(arg2));
-                        hexLines.push_back("45");
-                    }
-                    else if(inst == "INC") { //INC
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                        hexLines.push_back("48");
-                    }
-                    else if(inst == "DEC") { //DEC
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                        hexLines.push_back("49");
-                    }
-                    else if(inst == "LSH") { //LSH
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                        hexLines.push_back("4A");
-                    }
-                    else if(inst == "RSH") { //RSH
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                        hexLines.push_back("4B");
-                    }
-                    else if(inst == "INB") { //INB
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                        hexLines.push_back("81");
-                        for(string le : math::wordToLittleEndian(arg2))
-                            hexLines.push_back(le);
-                    }
-                    else if(inst == "OUTB") { //OUTB
-                        hexLines.push_back(label + math::argumentToRegister(arg1) + "0");
-                        hexLines.push_back("83");
-                        for(string le : math::wordToLittleEndian(arg2))
-                            hexLines.push_back(le);
-                    }
-                    else if(inst.substr(0, 3) == "TST" && inst.length() == 4) { //TSTI
-                        hexLines.push_back(label + "00");
-                        if(inst[3] == 'I') hexLines.push_back("84");
-                        else hexLines.push_back("85");
-                        for(string le : math::wordToLittleEndian(arg1))
-                            hexLines.push_back(le);
-                    }
-                    else if(inst == "BR") { //BR
-                        hexLines.push_back(label + "00");
-                        hexLines.push_back("C0");
-                        if(!math::vectorContains(labels, arg1))
-                            for(string le : math::wordToLittleEndian(arg1))
-                                hexLines.push_back(le);
-                        else
-                            hexLines.push_back(arg1); hexLines.push_back("");
-                    }
-                    else if(inst.substr(0, 3) == "JMP" && (inst.length() >= 3 && inst.length() <= 5)) {
-                        hexLines.push_back(label + arg1);
-                        if(inst.length() == 3) //JMP
-                            hexLines.push_back("C1");
-                        else if(inst.substr(3) == "Z") //JMPZ
-                            hexLines.push_back("C2");
-                        else if(inst.substr(3) == "NZ") //JMPNZ
-                            hexLines.push_back("C3");
-                        else if(inst.substr(3) == "N") //JMPN
-                            hexLines.push_back("C4");
-                        else if(inst.substr(3) == "NZ") //JMPNN
-                            hexLines.push_back("C5");
-                        else if(inst.substr(3) == "C") //JMPC
-                            hexLines.push_back("C6");
-                        else if(inst.substr(3) == "V") //JMPC
-                            hexLines.push_back("C7");
-                    }
-                    else if(inst == "CALL") { //CALL
-                        hexLines.push_back(label + "00");
-                        hexLines.push_back("C8");
-                        if(!math::vectorContains(labels, arg1))
-                            for(string le : math::wordToLittleEndian(arg1))
-                                hexLines.push_back(le);
-                        else
-                            hexLines.push_back(arg1); hexLines.push_back("");
-                    }
-                    else if(inst == "RET") { //RET
-                        hexLines.push_back(label + "00");
-                        hexLines.push_back("C9");
-                    }
-                    else if(inst == "HLT") { //HLT
-                        hexLines.push_back(label + "00");
-                        hexLines.push_back("CF");
-                    }
-                    else if(inst == "WORD") { //WORD
-                        vector<string> le = math::wordToLittleEndian(arg1);
-                            hexLines.push_back(label + le[0]);
-                            hexLines.push_back(le[1]);
-                    }
-                    else if(inst == "BYTE") { //BYTE
-                        hexLines.push_back(label + arg1);
-                    }
-                }
-                struct Label {
-                    string name;
-                    Uint16 address;
-                };
-                vector<Label> labelAddressAssociations;
-                for(int i = 0; i < hexLines.size(); i++) {
-                    string line = hexLines[i];
-                    int labelPos = line.find(':');
-                    if(labelPos != string::npos) {
-                        Label l;
-                        l.name = line.substr(0, labelPos);
-                        l.address = i;
-                        labelAddressAssociations.push_back(l);
-                        hexLines[i] = line.substr(labelPos + 1);
-                    }
-                }
-                for(int i = 0; i < hexLines.size(); i++) {
-                    string line = hexLines[i];
-                    int labelPos;
-                    for(Label l : labelAddressAssociations) {
-                        labelPos = line.find(l.name);
-                        if(labelPos != string::npos) {
-                            if(hexLines[i + 1] != "") {
-                                hexLines[i] = math::Uint8ToHexstr(Uint8(l.address - i - 2));
-                            }
-                            else {
-                                int j = 0;
-                                for(string s : math::wordToLittleEndian(math::Uint16ToHexstr(l.address))) {
-                                    hexLines[i + j] = s;
-                                    j++;
-                                }
-                            }
-                            break;
-                        }
-                    }
-                }
-                for(string l : hexLines) {
-                    outFile << l << endl;
-                }
-                outFile.close();
-                cout << logger->getStringTime() << logger->success << "Succesfully assembled file into hex executable"
-                    << logger->reset << endl;
-                settings->file = settings->file + ".hex";
-                settings->type = 1;
-                settings->ramSize = hexLines.size() + 0xF0; settings->ramSize -= settings->ramSize % 2;
-                for(Label l : labelAddressAssociations) {
-                    if(l.name == "START") {
-                        settings->start = l.address;
-                        break;
-                    }
-                }
-                loadProgram(settings, logger);
+            string source((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+            //Assembled images are cached by the hash of everything that affects them
+            Uint32 version = ASSEMBLER_VERSION;
+            Uint64 key = math::hash(&version, sizeof(version));
+            key = math::hash(&settings->start, sizeof(settings->start), key);
+            key = math::hash(source.data(), source.length(), key);
+            string cached = "binaries/.cache/" + math::Uint16ToHexstr(key >> 48) + math::Uint16ToHexstr(key >> 32)
+                + math::Uint16ToHexstr(key >> 16) + math::Uint16ToHexstr(key) + ".img";
+            if(ImageFile::load(cached, this, settings, logger)) {
+                logger->log(LOG_INFO, LOG_CACHE_LOADED, settings->file);
+                break;
             }
-            catch(int e) {
-                cout << logger->getStringTime() << logger->error << "Error while assembling file into hex executable"
-                    << logger->reset << endl;
+            logger->log(LOG_WARNING, LOG_ASSEMBLING);
+            Assembler assembler;
+            ProgramImage image;
+            image.start = settings->start;
+            if(!assembler.assemble(source, image)) {
+                for(const AssemblerDiagnostic& d : assembler.getDiagnostics())
+                    logger->log(LOG_ERROR, LOG_TEXT, settings->file + ":" + to_string(d.line) + ": " + d.message);
+                logger->log(LOG_ERROR, LOG_ASSEMBLY_FAILED);
+                break;
             }
+#ifdef _WIN32
+            _mkdir("binaries/.cache");
+#else
+            mkdir("binaries/.cache", 0755);
+#endif
+            if(!ImageFile::writeHex("binaries/" + settings->file + ".hex", image) ||
+                !ImageFile::write("binaries/" + settings->file + ".img", image) ||
+                !ImageFile::write(cached, image)) {
+                logger->log(LOG_ERROR, LOG_ASSEMBLY_WRITE_FAILED);
+                break;
+            }
+            logger->log(LOG_SUCCESS, LOG_ASSEMBLED);
+            ImageFile::load(cached, this, settings, logger);
     }
     file.close();
 }
@@ -1193,37 +1065,114 @@ void CentralMemory::operate() {
     Uint16 DB = SB->getData();
     ControlBus CB = SB->getControl();
     if(!CB.M) return;
-    if(AB >= size) return;
+    if(heatmap != NULL) {
+        heatmap->record(CB.R ? HEAT_READ : HEAT_WRITE, AB);
+        if(CB.W) heatmap->record(CB.R ? HEAT_READ : HEAT_WRITE, AB + 1);
+    }
+    //Every 16bit address is valid, cells outside the ram size always hold OPEN_BUS
     if(CB.R) {
         if(!CB.W)
             DB = M[AB];
-        else {
-            Uint8 a;
-            Uint16 b;
-            a = M[AB];
-            b = M[AB + 1] << 8;
-            DB = a | b;
-        }
+        else
+            DB = M[AB] | (M[AB + 1] << 8); //AB + 1 can be the guard byte
         SB->writeData(DB);
     }
     else {
         if(!CB.W)
-            M[AB] = DB;
+            store(AB, DB & 0xFF);
         else {
-            Uint8 a, b;
-            a = DB & 0xFF;
-            b = (DB & 0xFF00) >> 8;
-            M[AB] = a;
-            M[AB + 1] = b;
+            store(AB, DB & 0xFF);
+            store(AB + 1, (DB & 0xFF00) >> 8);
         }
     }
 }
 
+void CentralMemory::fetch() {
+    Uint16 AB = SB->getAddress();
+    ControlBus CB = SB->getControl();
+    if(heatmap != NULL) {
+        heatmap->record(HEAT_EXECUTE, AB);
+        if(CB.W) heatmap->record(HEAT_EXECUTE, AB + 1);
+    }
+    SB->writeData(CB.W ? (M[AB] | (M[AB + 1] << 8)) : M[AB]);
+}
+
+void CentralMemory::setHeatmap(MemoryHeatmap* pheatmap) {
+    heatmap = pheatmap;
+}
+
+void CentralMemory::loadBytes(Uint16 address, const Uint8* data, Uint32 length) {
+    if(address >= size) return;
+    length = min(length, size - address);
+    for(Uint32 i = 0; i < length; i++) set(address + i, data[i]);
+    M[MEMORY_SIZE] = M[0];
+    generation++;
+}
+
+Uint32 CentralMemory::patchProgram(const ProgramImage& previous, const ProgramImage& next,
+                                   vector<pair<Uint16, Uint16>>& conflicts) {
+    //A bigger program can grow the ram, the new cells already hold OPEN_BUS like a freshly reset memory
+    for(Uint32 grown = min(next.ramSize, Uint32(MEMORY_SIZE)); size < grown; size++) hash ^= cellHash(size, M[size]);
+    Uint32 patched = 0;
+    Uint32 length = max(previous.bytes.size(), next.bytes.size());
+    for(Uint32 i = 0; i < length; i++) {
+        Uint8 before = (i < previous.bytes.size()) ? previous.bytes[i] : 0x00;
+        Uint8 after = (i < next.bytes.size()) ? next.bytes[i] : 0x00;
+        Uint32 address = next.load + i;
+        if(before == after || address >= size || M[address] == after) continue;
+        if(M[address] == before) {
+            set(address, after);
+            patched++;
+        }
+        //The program wrote this cell, it is probably data now
+        else if(!conflicts.empty() && conflicts.back().second == address - 1)
+            conflicts.back().second = address;
+        else
+            conflicts.push_back(make_pair(Uint16(address), Uint16(address)));
+    }
+    M[MEMORY_SIZE] = M[0];
+    generation++;
+    return patched;
+}
+
 Uint8 CentralMemory::get(Uint16 address) {
-    if(address >= size) return 0x0;
     return M[address];
 }
 
+Uint32 CentralMemory::getGeneration() {
+    return generation;
+}
+
+Uint32 CentralMemory::getLineVersion(Uint16 address) {
+    return lineVersions[address / MEMORY_LINE];
+}
+
+Uint64 CentralMemory::getHash() {
+    return hash;
+}
+
+void CentralMemory::restore(const CentralMemory& snapshot) {
+    memcpy(M, snapshot.M, snapshot.size);
+    if(size > snapshot.size) memset(M + snapshot.size, OPEN_BUS, size - snapshot.size);
+    M[MEMORY_SIZE] = M[0];
+    sink = snapshot.sink;
+    size = snapshot.size;
+    hash = snapshot.hash;
+    generation++;
+}
+
+void CentralMemory::set(Uint32 address, Uint8 value) {
+    hash ^= cellHash(address, M[address]) ^ cellHash(address, value);
+    M[address] = value;
+}
+
+void CentralMemory::store(Uint16 address, Uint8 value) {
+    if(address < size) set(address, value);
+    else sink = value;
+    M[MEMORY_SIZE] = M[0];
+    lineVersions[address / MEMORY_LINE]++;
+}
+
 InputOutputDevices::InputOutputDevices(SystemBus* pSB) :SB(pSB) {
     reset();
 }
@@ -1335,4 +1284,26 @@ bool InputOutputDevices::getReceived() {
         return true;
     }
     return false;
-}
\ No newline at end of file
+}
+void InputOutputDevices::restore(const InputOutputDevices& snapshot) {
+    key = snapshot.key;
+    line0 = snapshot.line0;
+    line1 = snapshot.line1;
+    line2 = snapshot.line2;
+    line3 = snapshot.line3;
+    sent = snapshot.sent;
+    received = snapshot.received;
+}
+
+Uint64 InputOutputDevices::getHash() {
+    Uint8 flags[3] = {key, sent, received};
+    Uint64 h = math::hash(flags, sizeof(flags));
+    //The lengths are hashed too, so text cannot move from a line to the next one
+    const string* lines[4] = {&line0, &line1, &line2, &line3};
+    for(const string* line : lines) {
+        Uint64 length = line->size();
+        h = math::hash(&length, sizeof(length), h);
+        h = math::hash(line->data(), line->size(), h);
+    }
+    return h;
+}
@@ -0,0 +1,228 @@
+#include "session.hpp"
+
+using namespace std;
+
+/**
+ * @brief Function to write a number in as few bytes as possible, 7 bits per byte, the high bit means more follow
+ * @param file The file
+ * @param n The number
+*/
+static void writeVarint(ofstream& file, Uint64 n) {
+    for(; n >= 0x80; n >>= 7) file.put(char(n | 0x80));
+    file.put(char(n));
+}
+
+/**
+ * @brief Function to read a number written by writeVarint
+ * @param file The file
+ * @param n Where to store the number
+ * @returns True if read
+*/
+static bool readVarint(ifstream& file, Uint64& n) {
+    n = 0;
+    for(Uint8 shift = 0; shift < 64; shift += 7) {
+        int c = file.get();
+        if(c == EOF) return false;
+        n |= Uint64(c & 0x7F) << shift;
+        if(!(c & 0x80)) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Function to run the single phase the next button would run
+ * @param CPU The CPU
+*/
+static void nextPhase(CentralProcessingUnit& CPU) {
+    Uint8 now, next;
+    CPU.getPhases(now, next);
+    switch(next) {
+        case 0: CPU.fetchInstruction(); break;
+        case 1: CPU.decodeInstruction(); break;
+        case 2: CPU.fetchOperand(); break;
+        case 3: CPU.executeInstruction(); break;
+    }
+}
+
+SessionEvent::SessionEvent() :instructions(0), phase(0), type(SESSION_END), key(0x0), ramSize(0), start(0), hash(0) {}
+
+SessionRecorder::SessionRecorder() :machine(NULL), last(0) {}
+
+SessionRecorder::~SessionRecorder() {
+    stop();
+}
+
+bool SessionRecorder::start(string path, Machine* pmachine, InterpreterSettings settings) {
+    stop();
+    file.open(path, ios::binary | ios::trunc);
+    if(!file) return false;
+    machine = pmachine;
+    last = 0;
+    Uint32 magic = SESSION_MAGIC;
+    Uint16 version = SESSION_VERSION;
+    file.write((const char*)&magic, sizeof(magic));
+    file.write((const char*)&version, sizeof(version));
+    recordMemory(SESSION_RELOAD, settings);
+    return bool(file);
+}
+
+void SessionRecorder::record(Uint8 type, Uint8 key) {
+    if(machine == NULL) return;
+    stampEvent(type);
+    stamp.key = key;
+    write();
+}
+
+void SessionRecorder::recordMemory(Uint8 type, InterpreterSettings settings) {
+    if(machine == NULL) return;
+    stampEvent(type);
+    stamp.ramSize = min(settings.ramSize, Uint32(MEMORY_SIZE));
+    stamp.start = settings.start;
+    Uint32 length = stamp.ramSize;
+    while(length > 0 && machine->CM.get(length - 1) == 0x00) length--;
+    stamp.memory.resize(length);
+    for(Uint32 i = 0; i < length; i++) stamp.memory[i] = machine->CM.get(i);
+    write();
+}
+
+void SessionRecorder::stop() {
+    if(machine == NULL) return;
+    stampEvent(SESSION_END);
+    stamp.hash = machine->getHash();
+    write();
+    file.close();
+    machine = NULL;
+}
+
+void SessionRecorder::stampEvent(Uint8 type) {
+    Uint8 now, next;
+    machine->CPU.getPhases(now, next);
+    stamp.instructions = machine->CPU.getRetired();
+    stamp.phase = min(next, Uint8(SESSION_STOPPED));
+    stamp.type = type;
+}
+
+void SessionRecorder::write() {
+    //A reload resets the CPU, so its stamp and the next ones start again from 0
+    if(stamp.type == SESSION_RELOAD) last = 0;
+    file.put(char(stamp.type | (stamp.phase << 4)));
+    writeVarint(file, stamp.instructions - last);
+    last = stamp.instructions;
+    switch(stamp.type) {
+        case SESSION_INPUT:
+            file.put(char(stamp.key));
+            break;
+        case SESSION_RELOAD:
+        case SESSION_PATCH:
+            writeVarint(file, stamp.ramSize);
+            writeVarint(file, stamp.start);
+            writeVarint(file, stamp.memory.size());
+            file.write((const char*)stamp.memory.data(), stamp.memory.size());
+            break;
+        case SESSION_END:
+            file.write((const char*)&stamp.hash, sizeof(stamp.hash));
+            break;
+    }
+    //Events are rare, so they are flushed right away
+    file.flush();
+}
+
+bool Session::read(string path, vector<SessionEvent>& events) {
+    ifstream file(path, ios::binary);
+    Uint32 magic = 0;
+    Uint16 version = 0;
+    file.read((char*)&magic, sizeof(magic));
+    file.read((char*)&version, sizeof(version));
+    if(!file || magic != SESSION_MAGIC || version != SESSION_VERSION) return false;
+    Uint64 last = 0;
+    for(int c = file.get(); c != EOF; c = file.get()) {
+        SessionEvent e;
+        Uint64 delta, ramSize, start, length;
+        e.type = c & 0xF;
+        e.phase = c >> 4;
+        if(e.type == SESSION_RELOAD) last = 0;
+        if(!readVarint(file, delta)) break;
+        e.instructions = last + delta;
+        last = e.instructions;
+        if(e.type == SESSION_INPUT) {
+            c = file.get();
+            if(c == EOF) break;
+            e.key = c;
+        }
+        else if(e.type == SESSION_RELOAD || e.type == SESSION_PATCH) {
+            if(!readVarint(file, ramSize) || !readVarint(file, start) || !readVarint(file, length)) break;
+            e.ramSize = min(ramSize, Uint64(MEMORY_SIZE));
+            e.start = start;
+            e.memory.resize(min(length, Uint64(e.ramSize)));
+            file.read((char*)e.memory.data(), e.memory.size());
+            if(!file) break;
+        }
+        else if(e.type == SESSION_END) {
+            file.read((char*)&e.hash, sizeof(e.hash));
+            if(!file) break;
+        }
+        events.push_back(e);
+    }
+    return !events.empty();
+}
+
+Value Session::toJson(const vector<SessionEvent>& events) {
+    static const char* types[] = {"input", "next", "play", "fast", "pause", "reload", "patch", "end"};
+    Value root;
+    root["version"] = SESSION_VERSION;
+    root["events"] = Value(arrayValue);
+    for(const SessionEvent& e : events) {
+        Value v;
+        v["type"] = (e.type <= SESSION_END) ? types[e.type] : "unknown";
+        v["instructions"] = Json::UInt64(e.instructions);
+        v["phase"] = e.phase;
+        if(e.type == SESSION_INPUT) v["key"] = e.key;
+        else if(e.type == SESSION_RELOAD || e.type == SESSION_PATCH) {
+            v["ram_size"] = e.ramSize;
+            v["start"] = e.start;
+            string memory;
+            for(Uint8 b : e.memory) memory += math::Uint8ToHexstr(b);
+            v["memory"] = memory;
+        }
+        else if(e.type == SESSION_END)
+            v["hash"] = math::Uint16ToHexstr(e.hash >> 48) + math::Uint16ToHexstr(e.hash >> 32)
+                + math::Uint16ToHexstr(e.hash >> 16) + math::Uint16ToHexstr(e.hash);
+        root["events"].append(v);
+    }
+    return root;
+}
+
+bool Session::replay(const vector<SessionEvent>& events, Machine& machine, const Engine& engine) {
+    CentralProcessingUnit& CPU = machine.CPU;
+    //Like the GUI at startup
+    machine.IOD.input(0x0);
+    for(const SessionEvent& e : events) {
+        //Whole instructions at full speed, then the phases run with the next button
+        if(CPU.getRetired() < e.instructions) engine.run(CPU, e.instructions - CPU.getRetired());
+        Uint8 now, next;
+        CPU.getPhases(now, next);
+        while(next < SESSION_STOPPED && next != e.phase && CPU.getRetired() == e.instructions) {
+            nextPhase(CPU);
+            CPU.getPhases(now, next);
+        }
+        ProgramImage image;
+        switch(e.type) {
+            case SESSION_INPUT:
+                machine.IOD.input(e.key);
+                break;
+            case SESSION_RELOAD:
+                image.load = 0;
+                image.start = e.start;
+                image.bytes = e.memory;
+                machine.load(image, e.ramSize);
+                break;
+            case SESSION_PATCH:
+                machine.CM.reset(e.ramSize);
+                machine.CM.loadBytes(0, e.memory.data(), e.memory.size());
+                break;
+            case SESSION_END:
+                return machine.getHash() == e.hash;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,38 @@
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+#include <cerrno>
+#include <cstring>
+
+#include "unixsocket.hpp"
+
+using namespace std;
+
+int UnixSocket::listen(string path, int backlog) {
+#ifdef _WIN32
+    return -1;
+#else
+    sockaddr_un un;
+    memset(&un, 0, sizeof(un));
+    if(path.empty() || path.size() >= sizeof(un.sun_path)) return -1;
+    un.sun_family = AF_UNIX;
+    strcpy(un.sun_path, path.c_str());
+    //Only a stale socket is removed, a mistyped path must not delete the user's files
+    struct stat info;
+    if(lstat(path.c_str(), &info) == 0) {
+        if(!S_ISSOCK(info.st_mode)) return -1;
+        unlink(path.c_str());
+    }
+    else if(errno != ENOENT) return -1;
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(server < 0) return -1;
+    if(bind(server, (sockaddr*)&un, sizeof(un)) < 0 || ::listen(server, backlog) < 0) {
+        close(server);
+        return -1;
+    }
+    return server;
+#endif
+}
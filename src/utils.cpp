@@ -1,29 +1,178 @@
+#include <cstring>
+
 #include "utils.hpp"
 #include "math.h"
 
 using namespace std;
 using namespace Json;
 
-string Logger::getStringTime() {
-    time_t timet = time(0);
+static const char* logFormats[] = {
+    "%s",
+    "SDL Initialization FAILED! SDL_ERROR: %s",
+    "SDL Initialized Succesfully",
+    "IMG Initialization FAILED! IMG_ERROR: %s",
+    "IMG Initialized Succesfully",
+    "Window Initialization FAILED! SDL_ERROR: %s",
+    "Window Initialized Succesfully",
+    "Windwow Closed",
+    "Icon Loading FAILED! SDL_ERROR: %s",
+    "Icon %s Loaded Succesfully",
+    "Texture Loading FAILED! SDL_ERROR: %s",
+    "Texture %s Loaded Succesfully",
+    "File %s does not exist!",
+    "Image %s is truncated",
+    "Image %s has an unknown format",
+    "Image %s is corrupted",
+    "Error while loading image %s",
+    "Loaded cached assembly of %s",
+    "Assembling file into hex executable",
+    "Error while assembling file into hex executable",
+    "Error while writing the assembled file",
+    "Succesfully assembled file into hex executable",
+    "Cannot watch %s for changes",
+    "Hot reloaded %s, %lld bytes patched",
+    "Conflict in %s: 0x%04llX-0x%04llX was modified by the program, not patched",
+    "%s%lld log messages were dropped",
+    "%s was not built, packing the images at startup",
+    "Texture Atlas Loading FAILED! %s",
+    "Recording the session in %s",
+    "Cannot record the session in %s",
+    "Waiting for the debugger on %s",
+    "Cannot listen for the debugger on %s",
+    "Debugger connected",
+    "Debugger disconnected"
+};
+
+Logger::Logger() :cells(new LogCell[LOG_RING_SIZE]), head(0), tail(0), dropped(0), running(false), sleeping(false),
+    startTime(time(0)), startTicks(SDL_GetPerformanceCounter()), frequency(SDL_GetPerformanceFrequency()) {
+    for(Uint32 i = 0; i < LOG_RING_SIZE; i++) cells[i].sequence.store(i, memory_order_relaxed);
+    buffer.reserve(LOG_BUFFER_SIZE);
+}
+
+Logger::~Logger() {
+    stop();
+    drain();
+    flush();
+    delete[] cells;
+}
+
+void Logger::start() {
+    if(running) return;
+    running = true;
+    writer = thread(&Logger::write, this);
+}
+
+void Logger::stop() {
+    running = false;
+    {
+        lock_guard<mutex> lock(wakeMutex);
+        wake.notify_one();
+    }
+    if(writer.joinable()) writer.join();
+}
+
+void Logger::log(Uint8 level, Uint16 format, const char* text, Int64 a, Int64 b) {
+    //Claiming a slot, the sequence equals the position when the writer has freed it
+    Uint32 position = head.load(memory_order_relaxed);
+    LogCell* cell;
+    while(true) {
+        cell = &cells[position & (LOG_RING_SIZE - 1)];
+        Int32 difference = Int32(cell->sequence.load(memory_order_acquire) - position);
+        if(difference == 0) {
+            if(head.compare_exchange_weak(position, position + 1, memory_order_relaxed)) break;
+        }
+        else if(difference < 0) {
+            dropped.fetch_add(1, memory_order_relaxed);
+            return;
+        }
+        else position = head.load(memory_order_relaxed);
+    }
+    LogRecord& record = cell->record;
+    record.ticks = SDL_GetPerformanceCounter();
+    record.args[0] = a;
+    record.args[1] = b;
+    record.format = format;
+    record.level = level;
+    strncpy(record.text, text, LOG_TEXT_SIZE - 1);
+    record.text[LOG_TEXT_SIZE - 1] = '\0';
+    cell->sequence.store(position + 1, memory_order_release);
+    //Only the first record after the ring emptied finds the writer asleep, the lock is never waited for
+    if(sleeping.load() && wakeMutex.try_lock()) {
+        wake.notify_one();
+        wakeMutex.unlock();
+    }
+}
+
+void Logger::log(Uint8 level, Uint16 format, const string& text, Int64 a, Int64 b) {
+    log(level, format, text.c_str(), a, b);
+}
+
+void Logger::write() {
+    while(running) {
+        if(drain()) continue;
+        unique_lock<mutex> lock(wakeMutex);
+        sleeping.store(true);
+        //Checked again once asleep is announced, so a record queued in between is not left waiting
+        if(running && !pending()) wake.wait_for(lock, chrono::milliseconds(LOG_IDLE_WAIT));
+        sleeping.store(false);
+    }
+    drain();
+    flush();
+}
+
+bool Logger::pending() {
+    LogCell& cell = cells[tail & (LOG_RING_SIZE - 1)];
+    return Int32(cell.sequence.load(memory_order_acquire) - (tail + 1)) >= 0 || dropped.load(memory_order_relaxed) > 0;
+}
+
+bool Logger::drain() {
+    bool any = false;
+    while(true) {
+        LogCell& cell = cells[tail & (LOG_RING_SIZE - 1)];
+        if(Int32(cell.sequence.load(memory_order_acquire) - (tail + 1)) < 0) break;
+        format(cell.record);
+        //Giving the slot back to the producers for the next lap
+        cell.sequence.store(tail + LOG_RING_SIZE, memory_order_release);
+        tail++;
+        any = true;
+        if(buffer.length() >= LOG_BUFFER_SIZE) flush();
+    }
+    Uint32 lost = dropped.exchange(0, memory_order_relaxed);
+    if(lost > 0) {
+        LogRecord record = {SDL_GetPerformanceCounter(), {lost, 0}, LOG_DROPPED, LOG_WARNING, ""};
+        format(record);
+    }
+    //Everything available is written at once, the file is flushed only when the ring is empty
+    if(any || lost > 0) flush();
+    return any;
+}
+
+void Logger::format(const LogRecord& record) {
+    Uint64 elapsed = record.ticks - startTicks;
+    time_t timet = startTime + time_t(elapsed / frequency);
     tm *timei = localtime(&timet);
-    int day = timei->tm_mday, month = timei->tm_mon + 1, year = timei->tm_year + 1900,
-        hour = timei->tm_hour, minute = timei->tm_min, second = timei->tm_sec, tick = SDL_GetTicks() % 1000;
-    string s = "[";
-    if(day < 10) s += '0';
-    s += to_string(day) + '/';
-    if(month < 10) s+= '0';
-    s += to_string(month) + '/' + to_string(year) + ' ';
-    if(hour < 10) s += '0';
-    s += to_string(hour) + ':';
-    if(minute < 10) s += '0';
-    s += to_string(minute) + ':';
-    if(second < 10) s += '0';
-    s += to_string(second) + '.';
-    if(tick < 100) s += '0';
-    if(tick < 10) s += '0';
-    s += to_string(tick) + "] ";
-    return s;
+    char line[32 + LOG_TEXT_SIZE * 2];
+    int length = snprintf(line, sizeof(line), "[%02d/%02d/%d %02d:%02d:%02d.%03d] ", timei->tm_mday, timei->tm_mon + 1,
+        timei->tm_year + 1900, timei->tm_hour, timei->tm_min, timei->tm_sec, int(elapsed % frequency * 1000 / frequency));
+    buffer.append(line, length);
+    switch(record.level) {
+        case LOG_SUCCESS: buffer += success; break;
+        case LOG_ERROR: buffer += error; break;
+        case LOG_WARNING: buffer += warning; break;
+        default: buffer += info;
+    }
+    const char* f = (record.format < sizeof(logFormats) / sizeof(logFormats[0])) ? logFormats[record.format] : "%s";
+    length = snprintf(line, sizeof(line), f, record.text, (long long)record.args[0], (long long)record.args[1]);
+    buffer.append(line, min(length, int(sizeof(line) - 1)));
+    buffer += reset;
+    buffer += '\n';
+}
+
+void Logger::flush() {
+    if(buffer.empty()) return;
+    fwrite(buffer.data(), 1, buffer.length(), stdout);
+    fflush(stdout);
+    buffer.clear();
 }
 
 void Logger::setColors(ConsoleSettings c) {
@@ -70,9 +219,13 @@ ostream& operator << (ostream& os, const Settings& settings) {
             << "Output Color: " << ((settings.console.color) ? "true" : "false") << endl
             << "Interpreter File: " << settings.interpreter.file
             << " Type: " << ((settings.interpreter.type == 0) ? "binary" :
-                (settings.interpreter.type == 1) ? "hexadecimal" : "assembly") << endl
+                (settings.interpreter.type == 1) ? "hexadecimal" :
+                (settings.interpreter.type == 3) ? "image" : "assembly") << endl
             << "Interpreter Ram Size: " << settings.interpreter.ramSize << endl
-            << "Interpreter Start Address: " << settings.interpreter.start;
+            << "Interpreter Start Address: " << settings.interpreter.start << endl
+            << "Interpreter Hot Reload: " << ((settings.interpreter.hotReload) ? "true" : "false") << endl
+            << "Interpreter Clock: " << settings.interpreter.clock << " Hz" << endl
+            << "Interpreter Record: " << settings.interpreter.record;
 }
 
 Settings JsonManager::getSettings() {
@@ -136,10 +289,14 @@ Settings JsonManager::getSettings() {
         interpreter["start"] = 0x0000;
         errors++;
     }
+    settings.interpreter.hotReload = interpreter["hot_reload"].asBool();
+    settings.interpreter.clock = interpreter["clock"].asUInt();
+    settings.interpreter.record = interpreter["record"].asString();
     string binFile = settings.interpreter.file;
     Uint16 lenght = binFile.length();
     if(binFile.substr(lenght - 4) == ".bin") settings.interpreter.type = 0;
     else if(binFile.substr(lenght - 4) == ".hex") settings.interpreter.type = 1;
+    else if(binFile.substr(lenght - 4) == ".img") settings.interpreter.type = 3;
     else settings.interpreter.type = 2;
     file.close();
     if(errors > 0) {
@@ -0,0 +1,82 @@
+#include "viewer.hpp"
+
+using namespace std;
+
+MemoryViewer::MemoryViewer(Vector2f ppos, SDL_Texture* ptexture, Font* pfont)
+    :start(0x0), follow(VIEWER_FREE), generation(0), valid(false) {
+    //The rows have a fixed width so they are always written in place
+    string blank = "0000:" + string(2 * VIEWER_COLUMNS, '0') + " " + string(VIEWER_COLUMNS, '.');
+    for(Uint8 i = 0; i < VIEWER_ROWS; i++) {
+        rows.push_back(TextEntity(Vector2f(ppos.x, ppos.y + 6 * i), ptexture, pfont));
+        rows[i] = blank;
+        rowAddresses[i] = 0;
+        rowVersions[i] = 0;
+        for(Uint8 j = 0; j < VIEWER_COLUMNS; j++) rowBytes[i][j] = 0;
+    }
+}
+
+void MemoryViewer::scroll(Int32 count) {
+    follow = VIEWER_FREE;
+    start += count * VIEWER_COLUMNS;
+}
+
+void MemoryViewer::typeNibble(Uint8 n) {
+    follow = VIEWER_FREE;
+    start = (start << 4) | (n & 0xF);
+}
+
+void MemoryViewer::setFollow(Uint8 mode) {
+    follow = mode;
+}
+
+Uint8 MemoryViewer::getFollow() {
+    return follow;
+}
+
+void MemoryViewer::update(CentralMemory* CM, CentralProcessingUnit* CPU, Uint32 ramSize) {
+    if(ramSize == 0) return;
+    //Some rows of context are left above the followed address
+    if(follow == VIEWER_FOLLOW_PC) start = CPU->getPC() - 4 * VIEWER_COLUMNS;
+    else if(follow == VIEWER_FOLLOW_SP) start = CPU->getSP() - 4 * VIEWER_COLUMNS;
+    start -= start % VIEWER_COLUMNS;
+    if(CM->getGeneration() != generation) {
+        generation = CM->getGeneration();
+        valid = false;
+    }
+    Uint32 address = start % ramSize;
+    for(Uint8 i = 0; i < VIEWER_ROWS; i++) {
+        Uint16 cells[VIEWER_COLUMNS];
+        Uint32 version = 0;
+        for(Uint8 j = 0; j < VIEWER_COLUMNS; j++) {
+            cells[j] = (address + j) % ramSize;
+            version += CM->getLineVersion(cells[j]);
+        }
+        TextEntity& row = rows[i];
+        bool moved = !valid || rowAddresses[i] != cells[0], changed = false;
+        if(moved || rowVersions[i] != version) {
+            rowVersions[i] = version;
+            if(moved) {
+                rowAddresses[i] = cells[0];
+                row.setHex(0, cells[0], 4);
+            }
+            //"AAAA:BBBB cc", address, bytes and ASCII, a write elsewhere in the line leaves the row as it is
+            for(Uint8 j = 0; j < VIEWER_COLUMNS; j++) {
+                Uint8 c = CM->get(cells[j]);
+                if(!moved && rowBytes[i][j] == c) continue;
+                changed = true;
+                rowBytes[i][j] = c;
+                row.setHex(5 + 2 * j, c, 2);
+                //The font stops at '}'
+                row.changeAt(6 + 2 * VIEWER_COLUMNS + j, (c >= 0x20 && c < 0x7E) ? c : '.');
+            }
+        }
+        //Rows whose bytes changed since the last update are highlighted, not the ones that just scrolled in
+        row.setHighlight(!moved && changed);
+        address = (address + VIEWER_COLUMNS) % ramSize;
+    }
+    valid = true;
+}
+
+vector<TextEntity>& MemoryViewer::getRows() {
+    return rows;
+}
@@ -0,0 +1,97 @@
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "watcher.hpp"
+
+using namespace std;
+
+ProgramWatcher::ProgramWatcher() :running(false), updated(false), inotifyFd(-1), stopFd(-1) {}
+
+ProgramWatcher::~ProgramWatcher() {
+    stop();
+}
+
+bool ProgramWatcher::start(InterpreterSettings psettings) {
+    stop();
+    settings = psettings;
+#ifdef __linux__
+    if(settings.type != 2) return false;
+    vector<AssemblerDiagnostic> diagnostics;
+    //The image in memory is the one assembled from the file as it is now
+    if(!assemble(current, diagnostics)) return false;
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    //The directory is watched because editors often save by renaming a new file over the old one
+    if(inotifyFd < 0 || stopFd < 0 || inotify_add_watch(inotifyFd, "binaries", IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        stop();
+        return false;
+    }
+    running = true;
+    worker = thread(&ProgramWatcher::watch, this);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void ProgramWatcher::stop() {
+#ifdef __linux__
+    if(running) {
+        running = false;
+        Uint64 one = 1;
+        if(write(stopFd, &one, sizeof(one)) < 0) {}
+    }
+    if(worker.joinable()) worker.join();
+    if(inotifyFd >= 0) close(inotifyFd);
+    if(stopFd >= 0) close(stopFd);
+#endif
+    inotifyFd = stopFd = -1;
+    updated = false;
+}
+
+bool ProgramWatcher::poll(ProgramUpdate& pupdate) {
+    lock_guard<mutex> lock(updateMutex);
+    if(!updated) return false;
+    pupdate = update;
+    updated = false;
+    return true;
+}
+
+void ProgramWatcher::watch() {
+#ifdef __linux__
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+    while(running) {
+        if(::poll(fds, 2, -1) <= 0 || (fds[1].revents & POLLIN)) continue;
+        bool changed = false;
+        ssize_t length;
+        while((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+            for(char* p = buffer; p < buffer + length; ) {
+                inotify_event* event = (inotify_event*)p;
+                if(event->len > 0 && settings.file == event->name) changed = true;
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+        if(!changed) continue;
+        ProgramUpdate result;
+        result.previous = current;
+        result.assembled = assemble(result.next, result.diagnostics);
+        if(result.assembled) current = result.next;
+        lock_guard<mutex> lock(updateMutex);
+        update = result;
+        updated = true;
+    }
+#endif
+}
+
+bool ProgramWatcher::assemble(ProgramImage& image, vector<AssemblerDiagnostic>& diagnostics) {
+    Assembler assembler;
+    image.start = settings.start;
+    bool assembled = assembler.assembleFile("binaries/" + settings.file, image);
+    diagnostics = assembler.getDiagnostics();
+    return assembled;
+}
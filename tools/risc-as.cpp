@@ -0,0 +1,51 @@
+#include <iostream>
+
+#include "assembler.hpp"
+
+using namespace std;
+
+/**
+ * @brief Function to print the usage
+ * @param name The program name
+*/
+static void usage(const char* name) {
+    cout << "Usage: " << name << " [-o output.img] [-x output.hex] source.asm" << endl;
+}
+
+int main(int argc, char* args[]) {
+    string source, image, hex;
+    for(int i = 1; i < argc; i++) {
+        string arg = args[i];
+        if(arg == "-o" && i + 1 < argc) image = args[++i];
+        else if(arg == "-x" && i + 1 < argc) hex = args[++i];
+        else if(arg == "-h" || arg == "--help") {
+            usage(args[0]);
+            return 0;
+        }
+        else if(source == "" && arg[0] != '-') source = arg;
+        else {
+            usage(args[0]);
+            return 2;
+        }
+    }
+    if(source == "") {
+        usage(args[0]);
+        return 2;
+    }
+    if(image == "" && hex == "") image = source + ".img";
+    Assembler assembler;
+    ProgramImage program;
+    bool assembled = assembler.assembleFile(source, program);
+    for(const AssemblerDiagnostic& d : assembler.getDiagnostics())
+        cerr << source << ":" << d.line << ": error: " << d.message << endl;
+    if(!assembled) return 1;
+    if(image != "" && !ImageFile::write(image, program)) {
+        cerr << "Cannot write " << image << endl;
+        return 1;
+    }
+    if(hex != "" && !ImageFile::writeHex(hex, program)) {
+        cerr << "Cannot write " << hex << endl;
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include <iostream>
+
+#include "atlas.hpp"
+
+using namespace std;
+
+int main(int argc, char* args[]) {
+    if(argc > 1) {
+        cout << "Usage: " << args[0] << endl << "Packs the images in res into " << ATLAS_IMAGE << " and "
+            << ATLAS_TABLE << ", run it from the project folder" << endl;
+        return (string(args[1]) == "-h" || string(args[1]) == "--help") ? 0 : 2;
+    }
+    IMG_Init(IMG_INIT_PNG);
+    TextureAtlas atlas;
+    if(!atlas.pack() || !atlas.write(ATLAS_IMAGE, ATLAS_TABLE)) {
+        cerr << "Cannot build the atlas: " << atlas.getError() << endl;
+        return 1;
+    }
+    SDL_Surface* surface = atlas.wait();
+    cout << "Packed " << ATLAS_SPRITES << " images into " << surface->w << "x" << surface->h << endl;
+    IMG_Quit();
+    return 0;
+}
@@ -0,0 +1,548 @@
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "assembler.hpp"
+#include "engine.hpp"
+#include "unixsocket.hpp"
+
+using namespace std;
+
+#define DAEMON_MAX_MACHINES 4096 //Machines alive at the same time, each one takes about 80 KiB
+#define DAEMON_MAX_LINE (1 << 20) //Longest request, a connection that sends a longer one is closed
+#define DAEMON_MAX_RUN 1000000000 //Instructions run by a run request without a limit
+#define DAEMON_RUN_BLOCK (1 << 20) //Instructions run between two checks of the stop signal
+#define DAEMON_POLL_MS 200 //Longest wait before the stop signal is seen
+
+//JSON-RPC error codes
+#define RPC_PARSE_ERROR -32700
+#define RPC_INVALID_REQUEST -32600
+#define RPC_METHOD_NOT_FOUND -32601
+#define RPC_INVALID_PARAMS -32602
+#define RPC_UNKNOWN_MACHINE -32000
+#define RPC_LOAD_FAILED -32001
+#define RPC_TOO_MANY_MACHINES -32002
+
+/**
+ * @brief Structure that contains a client connection, shared by the workers while it has requests queued,
+ * its requests are handled by a single worker at a time in the order they arrived
+ * @param fd The socket
+ * @param writeMutex Lock held while a response is written
+ * @param buffer Bytes received and not parsed yet, only used by the main thread
+ * @param pending Requests not handled yet, guarded by jobsMutex
+ * @param scheduled True while the connection is queued or a worker handles one of its requests, guarded by jobsMutex
+*/
+struct DaemonConnection {
+    DaemonConnection(int pfd) :fd(pfd), scheduled(false) {}
+    ~DaemonConnection() {
+        close(fd);
+    }
+    int fd;
+    mutex writeMutex;
+    string buffer;
+    deque<string> pending;
+    bool scheduled;
+};
+
+/**
+ * @brief Structure that contains a machine of the pool, requests on the same machine run one at a time
+ * @param lock Lock held while the machine is used
+ * @param machine The machine
+*/
+struct DaemonMachine {
+    mutex lock;
+    Machine machine;
+};
+
+static const char* registerNames[] = {
+    "R0", "R1", "R2", "R3", "R4", "R5", "R6", "R7", "R8", "R9", "RA", "RB", "RC", "RD", "RE", "RF",
+    "PC", "IR", "SR", "AR", "DR", "SP"
+};
+
+static map<Uint64, shared_ptr<DaemonMachine>> pool;
+static mutex poolMutex;
+static Uint64 nextId = 1;
+static Uint32 maxMachines = DAEMON_MAX_MACHINES;
+static deque<shared_ptr<DaemonConnection>> jobs; //Connections with requests pending and no worker
+static mutex jobsMutex;
+static condition_variable jobsReady;
+static atomic<bool> stopping(false);
+static Logger logger; //Only the image loader logs
+
+/**
+ * @brief Function to stop the daemon on SIGINT and SIGTERM, the signal number is not needed
+*/
+static void stop(int) {
+    stopping = true;
+}
+
+/**
+ * @brief Function to write a whole response
+ * @param connection The connection
+ * @param response The response, ending with a newline
+*/
+static void respond(DaemonConnection& connection, const string& response) {
+    lock_guard<mutex> lock(connection.writeMutex);
+    for(size_t sent = 0; sent < response.size(); ) {
+        ssize_t n = send(connection.fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if(n <= 0) return;
+        sent += n;
+    }
+}
+
+/**
+ * @brief Function to write a value on a single line
+ * @param value The value
+ * @returns The JSON without the newline, type string
+*/
+static string compact(const Value& value) {
+    string text = FastWriter().write(value);
+    text.pop_back();
+    return text;
+}
+
+/**
+ * @brief Function to build the start of a response, the result or the error follow
+ * @param id The request id
+ * @returns The response up to the result key, type string
+*/
+static string responseHead(const Value& id) {
+    return "{\"jsonrpc\":\"2.0\",\"id\":" + compact(id) + ",";
+}
+
+/**
+ * @brief Function to build a response with a result
+ * @param id The request id
+ * @param result The result
+ * @returns The response, type string
+*/
+static string resultResponse(const Value& id, const Value& result) {
+    return responseHead(id) + "\"result\":" + compact(result) + "}\n";
+}
+
+/**
+ * @brief Function to build a response with an error
+ * @param id The request id
+ * @param code The error code, RPC_*
+ * @param message The error message
+ * @returns The response, type string
+*/
+static string errorResponse(const Value& id, int code, string message) {
+    Value error;
+    error["code"] = code;
+    error["message"] = message;
+    return responseHead(id) + "\"error\":" + compact(error) + "}\n";
+}
+
+/**
+ * @brief Function to decode an hexadecimal string
+ * @param s The string
+ * @param bytes Where to store the bytes
+ * @returns True if it only has pairs of hexadecimal digits
+*/
+static bool hexToBytes(const string& s, vector<Uint8>& bytes) {
+    if(s.size() % 2 != 0 || s.find_first_not_of("0123456789abcdefABCDEF") != string::npos) return false;
+    bytes.resize(s.size() / 2);
+    for(size_t i = 0; i < bytes.size(); i++) bytes[i] = math::hexstrToUint8(s.substr(i * 2, 2));
+    return true;
+}
+
+/**
+ * @brief Function to find a machine of the pool
+ * @param params The request params, with the id in machine
+ * @param key The param name
+ * @returns The machine, NULL if there is none with that id
+*/
+static shared_ptr<DaemonMachine> findMachine(const Value& params, const char* key) {
+    if(!params[key].isUInt64()) return NULL;
+    lock_guard<mutex> lock(poolMutex);
+    map<Uint64, shared_ptr<DaemonMachine>>::iterator it = pool.find(params[key].asUInt64());
+    return (it != pool.end()) ? it->second : NULL;
+}
+
+/**
+ * @brief Function to add a machine to the pool
+ * @param machine The machine
+ * @returns The id, 0 if the pool is full
+*/
+static Uint64 addMachine(shared_ptr<DaemonMachine> machine) {
+    lock_guard<mutex> lock(poolMutex);
+    if(pool.size() >= maxMachines) return 0;
+    pool[nextId] = machine;
+    return nextId++;
+}
+
+/**
+ * @brief Function to get the state of a CPU as the result of a request
+ * @param CPU The CPU
+ * @returns The result, type Value
+*/
+static Value cpuState(CentralProcessingUnit& CPU) {
+    Value result;
+    Uint8 now, next;
+    CPU.getPhases(now, next);
+    result["state"] = (next == 0xF0) ? "halted" : (next == 0xFF) ? "error" : "running";
+    result["retired"] = Json::UInt64(CPU.getRetired());
+    result["pc"] = CPU.getPC();
+    return result;
+}
+
+/**
+ * @brief Function to create a machine, from assembly source, an assembly or image file, or bytes
+ * @param params The request params
+ * @param response Where to store the response
+ * @param id The request id
+*/
+static void create(const Value& params, string& response, const Value& id) {
+    shared_ptr<DaemonMachine> entry = make_shared<DaemonMachine>();
+    Machine& machine = entry->machine;
+    Uint32 ramSize = min(params.get("ram_size", MEMORY_SIZE).asUInt(), Uint32(MEMORY_SIZE));
+    ProgramImage image;
+    image.start = params.get("start", 0).asUInt();
+    Assembler assembler;
+    string file = params.get("file", "").asString();
+    if(params.isMember("source") || (file.size() > 4 && file.substr(file.size() - 4) == ".asm")) {
+        bool assembled = params.isMember("source") ? assembler.assemble(params["source"].asString(), image)
+            : assembler.assembleFile(file, image);
+        if(!assembled) {
+            string message = "cannot assemble";
+            if(!assembler.getDiagnostics().empty())
+                message += ", line " + to_string(assembler.getDiagnostics()[0].line) + ": "
+                    + assembler.getDiagnostics()[0].message;
+            response = errorResponse(id, RPC_LOAD_FAILED, message);
+            return;
+        }
+        machine.load(image, ramSize);
+    }
+    else if(file != "") {
+        //Images carry their own memory size and start address
+        InterpreterSettings settings;
+        settings.file = file;
+        if(!ImageFile::load(file, &machine.CM, &settings, &logger)) {
+            response = errorResponse(id, RPC_LOAD_FAILED, "cannot load " + file);
+            return;
+        }
+        machine.IOD.reset();
+        machine.CPU.reset(settings);
+    }
+    else if(params.isMember("bytes")) {
+        image.load = params.get("load", 0).asUInt();
+        if(!hexToBytes(params["bytes"].asString(), image.bytes)) {
+            response = errorResponse(id, RPC_INVALID_PARAMS, "bytes is not hexadecimal");
+            return;
+        }
+        machine.load(image, ramSize);
+    }
+    else {
+        response = errorResponse(id, RPC_INVALID_PARAMS, "one of source, file or bytes is needed");
+        return;
+    }
+    machine.IOD.input(0x0);
+    Uint64 machineId = addMachine(entry);
+    if(machineId == 0) {
+        response = errorResponse(id, RPC_TOO_MANY_MACHINES, "the pool is full");
+        return;
+    }
+    Value result;
+    result["machine"] = Json::UInt64(machineId);
+    response = resultResponse(id, result);
+}
+
+/**
+ * @brief Function to read a memory range, the hexadecimal digits are written straight in the response
+ * @param machine The machine
+ * @param params The request params
+ * @param id The request id
+ * @returns The response, type string
+*/
+static string readMemory(Machine& machine, const Value& params, const Value& id) {
+    static const char digits[] = "0123456789ABCDEF";
+    Uint32 address = params.get("address", 0).asUInt() & 0xFFFF;
+    Uint32 length = min(params.get("length", 0).asUInt(), Uint32(MEMORY_SIZE));
+    string head = responseHead(id) + "\"result\":{\"address\":" + to_string(address) + ",\"data\":\"";
+    string response;
+    response.reserve(head.size() + length * 2 + 4);
+    response = head;
+    size_t at = response.size();
+    response.resize(at + length * 2);
+    //The address space wraps, like the CPU reads
+    for(Uint32 i = 0; i < length; i++) {
+        Uint8 b = machine.CM.get((address + i) & 0xFFFF);
+        response[at++] = digits[b >> 4];
+        response[at++] = digits[b & 0xF];
+    }
+    response += "\"}}\n";
+    return response;
+}
+
+/**
+ * @brief Function to handle a request on a machine, the machine is locked
+ * @param method The method
+ * @param machine The machine
+ * @param params The request params
+ * @param id The request id
+ * @returns The response, type string
+*/
+static string handleMachine(const string& method, Machine& machine, const Value& params, const Value& id) {
+    Value result;
+    if(method == "run") {
+        const Engine* engine = Engines::find(params.get("engine", Engines::get(ENGINE_FASTEST).name).asString());
+        if(engine == NULL) return errorResponse(id, RPC_INVALID_PARAMS, "unknown engine");
+        Uint64 limit = params.isMember("instructions") ? params["instructions"].asUInt64() : DAEMON_MAX_RUN;
+        Uint64 retired = 0;
+        //In blocks, so a stop signal does not wait for a long run
+        while(retired < limit && !stopping) {
+            Uint64 block = min(limit - retired, Uint64(DAEMON_RUN_BLOCK));
+            Uint64 n = engine->run(machine.CPU, block);
+            retired += n;
+            if(n < block) break;
+        }
+        result = cpuState(machine.CPU);
+        result["instructions"] = Json::UInt64(retired);
+        return resultResponse(id, result);
+    }
+    if(method == "input") {
+        if(!params["key"].isUInt() || params["key"].asUInt() > 0xFF)
+            return errorResponse(id, RPC_INVALID_PARAMS, "key has to be a byte");
+        machine.IOD.input(params["key"].asUInt());
+        return resultResponse(id, true);
+    }
+    if(method == "write") {
+        vector<Uint8> bytes;
+        if(!hexToBytes(params.get("data", "").asString(), bytes) || bytes.size() > MEMORY_SIZE)
+            return errorResponse(id, RPC_INVALID_PARAMS, "data is not hexadecimal");
+        Uint32 address = params.get("address", 0).asUInt() & 0xFFFF;
+        //Bytes past the end of the address space wrap, like the CPU writes
+        Uint32 first = min(Uint32(bytes.size()), MEMORY_SIZE - address);
+        machine.CM.loadBytes(address, bytes.data(), first);
+        if(first < bytes.size()) machine.CM.loadBytes(0, bytes.data() + first, bytes.size() - first);
+        return resultResponse(id, true);
+    }
+    if(method == "read") return readMemory(machine, params, id);
+    if(method == "registers") {
+        result = cpuState(machine.CPU);
+        for(Uint8 r = 0; r < sizeof(registerNames) / sizeof(registerNames[0]); r++)
+            result["registers"][registerNames[r]] = machine.CPU.getRegister(r);
+        return resultResponse(id, result);
+    }
+    if(method == "output") {
+        string lines[4];
+        machine.IOD.getLines(lines[0], lines[1], lines[2], lines[3]);
+        result = Value(arrayValue);
+        for(const string& l : lines) result.append(l);
+        return resultResponse(id, result);
+    }
+    return errorResponse(id, RPC_METHOD_NOT_FOUND, "unknown method " + method);
+}
+
+/**
+ * @brief Function to handle a request on the pool
+ * @param method The method
+ * @param params The request params
+ * @param id The request id
+ * @returns The response, type string
+*/
+static string dispatch(const string& method, const Value& params, const Value& id) {
+    if(method == "create") {
+        string response;
+        create(params, response, id);
+        return response;
+    }
+    shared_ptr<DaemonMachine> entry = findMachine(params, "machine");
+    if(entry == NULL) return errorResponse(id, RPC_UNKNOWN_MACHINE, "unknown machine");
+    if(method == "destroy") {
+        lock_guard<mutex> lock(poolMutex);
+        pool.erase(params["machine"].asUInt64());
+        return resultResponse(id, true);
+    }
+    if(method == "snapshot") {
+        //A snapshot is a new machine with the same state, it can be run or restored from
+        shared_ptr<DaemonMachine> copy = make_shared<DaemonMachine>();
+        {
+            lock_guard<mutex> lock(entry->lock);
+            copy->machine.restore(entry->machine);
+        }
+        Uint64 copyId = addMachine(copy);
+        if(copyId == 0) return errorResponse(id, RPC_TOO_MANY_MACHINES, "the pool is full");
+        Value result;
+        result["machine"] = Json::UInt64(copyId);
+        return resultResponse(id, result);
+    }
+    if(method == "restore") {
+        shared_ptr<DaemonMachine> snapshot = findMachine(params, "snapshot");
+        if(snapshot == NULL) return errorResponse(id, RPC_UNKNOWN_MACHINE, "unknown snapshot");
+        if(snapshot == entry) return resultResponse(id, true);
+        //Both locks at once, two restores in opposite directions would deadlock otherwise
+        unique_lock<mutex> a(entry->lock, defer_lock), b(snapshot->lock, defer_lock);
+        lock(a, b);
+        entry->machine.restore(snapshot->machine);
+        return resultResponse(id, true);
+    }
+    lock_guard<mutex> lock(entry->lock);
+    return handleMachine(method, entry->machine, params, id);
+}
+
+/**
+ * @brief Function to handle a request
+ * @param line The request
+ * @param answer Set to false for a notification, it is not answered
+ * @returns The response, type string
+*/
+static string handle(const string& line, bool& answer) {
+    Value request, id;
+    answer = true;
+    if(!Reader().parse(line, request, false)) return errorResponse(id, RPC_PARSE_ERROR, "parse error");
+    if(!request.isObject() || !request["method"].isString())
+        return errorResponse(id, RPC_INVALID_REQUEST, "invalid request");
+    answer = request.isMember("id");
+    id = request["id"];
+    const Value& params = request["params"];
+    if(!params.isNull() && !params.isObject()) return errorResponse(id, RPC_INVALID_PARAMS, "params has to be an object");
+    try {
+        return dispatch(request["method"].asString(), params, id);
+    }
+    catch(const exception& e) {
+        //jsoncpp throws when a param has the wrong type
+        return errorResponse(id, RPC_INVALID_PARAMS, e.what());
+    }
+}
+
+/**
+ * @brief Function run by every worker, it handles a request of the first connection waiting,
+ * a pipelined request starts only after the previous one on the same connection has been answered
+*/
+static void work() {
+    while(true) {
+        shared_ptr<DaemonConnection> connection;
+        string line;
+        {
+            unique_lock<mutex> lock(jobsMutex);
+            jobsReady.wait(lock, [] {return stopping || !jobs.empty();});
+            //The requests still queued are dropped, the clients see the connection closed
+            if(stopping) return;
+            connection = move(jobs.front());
+            jobs.pop_front();
+            line = move(connection->pending.front());
+            connection->pending.pop_front();
+        }
+        bool answer;
+        string response = handle(line, answer);
+        if(answer) respond(*connection, response);
+        lock_guard<mutex> lock(jobsMutex);
+        //Queued again at the back, so a busy connection does not starve the others
+        if(connection->pending.empty()) connection->scheduled = false;
+        else {
+            jobs.push_back(connection);
+            jobsReady.notify_one();
+        }
+    }
+}
+
+/**
+ * @brief Function to read from a connection and queue its whole requests
+ * @param connection The connection
+ * @returns False if it was closed or it sent a request too long
+*/
+static bool receive(shared_ptr<DaemonConnection> connection) {
+    char data[65536];
+    ssize_t n = recv(connection->fd, data, sizeof(data), 0);
+    if(n <= 0) return false;
+    string& buffer = connection->buffer;
+    size_t from = buffer.size();
+    buffer.append(data, n);
+    size_t start = 0;
+    for(size_t end = buffer.find('\n', from); end != string::npos; end = buffer.find('\n', start)) {
+        if(end > start) {
+            lock_guard<mutex> lock(jobsMutex);
+            connection->pending.push_back(buffer.substr(start, end - start));
+            if(!connection->scheduled) {
+                connection->scheduled = true;
+                jobs.push_back(connection);
+                jobsReady.notify_one();
+            }
+        }
+        start = end + 1;
+    }
+    buffer.erase(0, start);
+    return buffer.size() <= DAEMON_MAX_LINE;
+}
+
+/**
+ * @brief Function to print the usage
+ * @param name The program name
+*/
+static void usage(const char* name) {
+    cout << "Usage: " << name << " [-j threads] [-m max machines] socket" << endl
+        << "Serves a pool of machines on a unix socket, one JSON-RPC 2.0 request per line, the methods are" << endl
+        << "create, input, write, run, registers, read, output, snapshot, restore and destroy" << endl;
+}
+
+int main(int argc, char* args[]) {
+    string path;
+    Uint32 threads = max(thread::hardware_concurrency(), 1u);
+    for(int i = 1; i < argc; i++) {
+        string arg = args[i];
+        if(arg == "-j" && i + 1 < argc) threads = max(atoi(args[++i]), 1);
+        else if(arg == "-m" && i + 1 < argc) maxMachines = strtoul(args[++i], NULL, 0);
+        else if(arg == "-h" || arg == "--help") {
+            usage(args[0]);
+            return 0;
+        }
+        else if(path == "" && arg[0] != '-') path = arg;
+        else {
+            usage(args[0]);
+            return 2;
+        }
+    }
+    if(path == "") {
+        usage(args[0]);
+        return 2;
+    }
+    int server = UnixSocket::listen(path, SOMAXCONN);
+    if(server < 0) {
+        cerr << "Cannot listen on " << path << endl;
+        return 1;
+    }
+    logger.start();
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    cout << "Listening on " << path << " with " << threads << " threads" << endl;
+    vector<thread> workers;
+    for(Uint32 i = 0; i < threads; i++) workers.push_back(thread(work));
+    //The main thread only reads, the requests are handled by the workers
+    vector<shared_ptr<DaemonConnection>> connections;
+    vector<pollfd> fds;
+    while(!stopping) {
+        fds.assign(1, pollfd{server, POLLIN, 0});
+        for(const shared_ptr<DaemonConnection>& c : connections) fds.push_back(pollfd{c->fd, POLLIN, 0});
+        if(poll(fds.data(), fds.size(), DAEMON_POLL_MS) <= 0) continue;
+        //Backwards, so the closed connections can be removed while iterating
+        for(size_t i = connections.size(); i > 0; i--) {
+            if(!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            if(!receive(connections[i - 1])) connections.erase(connections.begin() + (i - 1));
+        }
+        if(fds[0].revents & POLLIN) {
+            int client = accept(server, NULL, NULL);
+            if(client >= 0) connections.push_back(make_shared<DaemonConnection>(client));
+        }
+    }
+    {
+        lock_guard<mutex> lock(jobsMutex);
+        jobsReady.notify_all();
+    }
+    for(thread& t : workers) t.join();
+    close(server);
+    unlink(path.c_str());
+    return 0;
+}
@@ -0,0 +1,260 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "assembler.hpp"
+#include "engine.hpp"
+
+using namespace std;
+
+#define FUZZ_INSTRUCTIONS 1000 //Instructions run by every case
+#define FUZZ_RAM_SIZE 0x4000 //Smaller than the address space, so the open bus is reached too
+#define FUZZ_MAX_LENGTH 256 //Bytes of a random instruction stream
+#define FUZZ_MAX_MUTATIONS 8 //Mutations of a corpus program
+#define FUZZ_MAX_SAVED 64 //Failing inputs written before the others are only counted
+#define FUZZ_SECONDS 60
+#define FUZZ_OUTPUT "fuzz"
+
+/**
+ * @brief Structure that contains the fuzzer options, shared by every worker
+ * @param cases The number of cases to run, 0 for no limit
+ * @param seconds The time limit
+ * @param instructions The instructions run by every case
+ * @param ramSize The memory size
+ * @param seed The first seed, every worker starts from a different one
+ * @param output The folder for the failing inputs
+ * @param corpus The programs to mutate, can be empty
+*/
+struct FuzzOptions {
+    Uint64 cases;
+    double seconds;
+    Uint64 instructions;
+    Uint32 ramSize;
+    Uint64 seed;
+    string output;
+    vector<vector<Uint8>> corpus;
+};
+
+static atomic<Uint64> executed(0), failures(0), saved(0);
+static atomic<bool> stopping(false);
+static mutex outputMutex;
+
+/**
+ * @brief Function to get the next pseudorandom number, xorshift64*
+ * @param state The generator state, not 0
+ * @returns The number
+*/
+static inline Uint64 nextRandom(Uint64& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1D;
+}
+
+/**
+ * @brief Function to generate the instruction stream of a case, random or mutated from the corpus
+ * @param state The generator state
+ * @param corpus The programs to mutate
+ * @param bytes Where to store the stream
+*/
+static void generate(Uint64& state, const vector<vector<Uint8>>& corpus, vector<Uint8>& bytes) {
+    Uint64 r = nextRandom(state);
+    if(corpus.empty() || (r & 1)) {
+        bytes.resize(2 + 2 * ((r >> 1) % (FUZZ_MAX_LENGTH / 2)));
+        for(size_t i = 0; i < bytes.size(); i += 8) {
+            Uint64 word = nextRandom(state);
+            for(size_t j = i; j < i + 8 && j < bytes.size(); j++, word >>= 8) bytes[j] = word;
+        }
+        return;
+    }
+    bytes = corpus[(r >> 1) % corpus.size()];
+    bytes.resize(max((bytes.size() + 1) & ~size_t(1), size_t(2)));
+    for(Uint64 m = 1 + (r >> 32) % FUZZ_MAX_MUTATIONS; m > 0; m--) {
+        Uint64 x = nextRandom(state);
+        size_t at = (x >> 8) % bytes.size(), word = ((x >> 32) % (bytes.size() / 2)) * 2;
+        switch(x & 3) {
+            case 0: bytes[at] ^= 1 << ((x >> 4) & 7); break; //Bit flip
+            case 1: bytes[at] = x >> 56; break; //Random byte
+            case 2: { //Duplicate word
+                Uint8 copy[2] = {bytes[word], bytes[word + 1]};
+                bytes.insert(bytes.begin() + word, copy, copy + 2);
+                break;
+            }
+            case 3: swap(bytes[word], bytes[at & ~size_t(1)]); swap(bytes[word + 1], bytes[at | 1]); break; //Swap words
+        }
+    }
+    if(bytes.size() > MEMORY_SIZE) bytes.resize(MEMORY_SIZE);
+}
+
+/**
+ * @brief Function to save a failing input as an hexadecimal file, it can be loaded by the simulator
+ * @param options The options
+ * @param reason A short name of the failed check
+ * @param bytes The input
+*/
+static void save(const FuzzOptions& options, string reason, const vector<Uint8>& bytes) {
+    failures++;
+    if(saved++ >= FUZZ_MAX_SAVED) return;
+    ProgramImage image;
+    image.load = image.start = 0;
+    image.ramSize = options.ramSize;
+    image.bytes = bytes;
+    Uint64 key = math::hash(bytes.data(), bytes.size());
+    string path = options.output + "/" + reason + "-" + math::Uint16ToHexstr(key >> 48) + math::Uint16ToHexstr(key >> 32)
+        + math::Uint16ToHexstr(key >> 16) + math::Uint16ToHexstr(key) + ".hex";
+    bool written = ImageFile::writeHex(path, image);
+    lock_guard<mutex> lock(outputMutex);
+    cout << reason << ": " << (written ? path : "cannot write " + path) << endl;
+}
+
+/**
+ * @brief Function to check that the word read at the last address wraps to the first cell, through the guard byte
+ * @param machine The machine
+ * @returns True if it wraps
+*/
+static bool wraps(Machine& machine) {
+    machine.SB.writeAddress(0xFFFF);
+    machine.SB.writeControl(ControlBus(READ, MEMORY, WORD));
+    machine.CM.operate();
+    return machine.SB.getData() == (machine.CM.get(0xFFFF) | (machine.CM.get(0x0000) << 8));
+}
+
+/**
+ * @brief Function run by every worker, each one has its own machines
+ * @param options The options
+ * @param index The worker index
+*/
+static void work(const FuzzOptions& options, Uint32 index) {
+    Uint64 state = math::mix(options.seed + index) | 1;
+    const Engine& referenceEngine = Engines::get(0);
+    //Every case starts from this snapshot instead of resetting and loading the machines
+    Machine clean, reference;
+    vector<Machine> candidates(ENGINES - 1);
+    ProgramImage empty;
+    empty.load = empty.start = 0;
+    clean.load(empty, options.ramSize);
+    vector<Uint8> bytes;
+    while(!stopping) {
+        if(executed++ >= options.cases && options.cases > 0) break;
+        generate(state, options.corpus, bytes);
+        reference.restore(clean);
+        reference.CM.loadBytes(0, bytes.data(), bytes.size());
+        //The reference runs an instruction at a time to check the invariants after each one
+        Uint64 instructions = 0;
+        bool failed = false;
+        while(instructions < options.instructions) {
+            Uint16 sp = reference.CPU.getSP();
+            if(referenceEngine.run(reference.CPU, 1) == 0) break;
+            instructions++;
+            //Only SPWR moves the stack pointer by more than a word
+            Uint16 moved = reference.CPU.getSP() - sp;
+            if(moved != 0 && moved != 2 && moved != 0xFFFE && (reference.CPU.getIR() & 0xFF00) != 0x0E00) {
+                save(options, "sp", bytes);
+                failed = true;
+                break;
+            }
+        }
+        if(failed) continue;
+        if(!wraps(reference)) {
+            save(options, "wrap", bytes);
+            continue;
+        }
+        Uint64 hash = reference.getHash();
+        for(Uint8 e = 1; e < ENGINES; e++) {
+            Machine& candidate = candidates[e - 1];
+            candidate.restore(clean);
+            candidate.CM.loadBytes(0, bytes.data(), bytes.size());
+            if(Engines::get(e).run(candidate.CPU, options.instructions) != instructions || candidate.getHash() != hash) {
+                save(options, Engines::get(e).name, bytes);
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Function to print the usage
+ * @param name The program name
+*/
+static void usage(const char* name) {
+    cout << "Usage: " << name << " [-j threads] [-n cases] [-t seconds] [-i instructions] [-m ram size] [-s seed]"
+        << " [-o folder] [corpus.asm ...]" << endl
+        << "Runs random and mutated instruction streams, checks the invariants and that every engine agrees with "
+        << Engines::get(0).name << "," << endl
+        << "the failing inputs are saved as .hex files, loaded at 0 and started from 0" << endl;
+}
+
+int main(int argc, char* args[]) {
+    FuzzOptions options;
+    options.cases = 0;
+    options.seconds = FUZZ_SECONDS;
+    options.instructions = FUZZ_INSTRUCTIONS;
+    options.ramSize = FUZZ_RAM_SIZE;
+    options.seed = chrono::steady_clock::now().time_since_epoch().count();
+    options.output = FUZZ_OUTPUT;
+    Uint32 threads = max(thread::hardware_concurrency(), 1u);
+    for(int i = 1; i < argc; i++) {
+        string arg = args[i];
+        if(arg == "-j" && i + 1 < argc) threads = max(atoi(args[++i]), 1);
+        else if(arg == "-n" && i + 1 < argc) options.cases = strtoull(args[++i], NULL, 0);
+        else if(arg == "-t" && i + 1 < argc) options.seconds = atof(args[++i]);
+        else if(arg == "-i" && i + 1 < argc) options.instructions = strtoull(args[++i], NULL, 0);
+        else if(arg == "-m" && i + 1 < argc) options.ramSize = min(Uint32(strtoul(args[++i], NULL, 0)), Uint32(MEMORY_SIZE));
+        else if(arg == "-s" && i + 1 < argc) options.seed = strtoull(args[++i], NULL, 0);
+        else if(arg == "-o" && i + 1 < argc) options.output = args[++i];
+        else if(arg == "-h" || arg == "--help") {
+            usage(args[0]);
+            return 0;
+        }
+        else if(arg[0] != '-') {
+            Assembler assembler;
+            ProgramImage image;
+            if(!assembler.assembleFile(arg, image)) {
+                for(const AssemblerDiagnostic& d : assembler.getDiagnostics())
+                    cerr << arg << ":" << d.line << ": error: " << d.message << endl;
+                return 1;
+            }
+            options.corpus.push_back(image.bytes);
+        }
+        else {
+            usage(args[0]);
+            return 2;
+        }
+    }
+#ifdef _WIN32
+    _mkdir(options.output.c_str());
+#else
+    mkdir(options.output.c_str(), 0755);
+#endif
+    cout << "Seed " << options.seed << ", " << threads << " threads, " << options.instructions << " instructions per case"
+        << endl;
+    vector<thread> workers;
+    for(Uint32 i = 0; i < threads; i++) workers.push_back(thread(work, cref(options), i));
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Uint64 reported = 0;
+    double seconds = 0;
+    bool done = false;
+    while(!done) {
+        this_thread::sleep_for(chrono::milliseconds(50));
+        seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        done = seconds >= options.seconds || (options.cases > 0 && executed >= options.cases);
+        //A report every second and one at the end
+        if(Uint64(seconds) == reported && !done) continue;
+        reported = Uint64(seconds);
+        Uint64 cases = (options.cases > 0) ? min(executed.load(), options.cases) : executed.load();
+        lock_guard<mutex> lock(outputMutex);
+        cout << cases << " cases, " << Uint64(cases / seconds * 60) << " per minute, " << failures << " failures" << endl;
+    }
+    stopping = true;
+    for(thread& t : workers) t.join();
+    return (failures > 0) ? 1 : 0;
+}
@@ -0,0 +1,72 @@
+#include <chrono>
+#include <iostream>
+
+#include "session.hpp"
+
+using namespace std;
+
+/**
+ * @brief Function to print the usage
+ * @param name The program name
+*/
+static void usage(const char* name) {
+    cout << "Usage: " << name << " [-e engine] [-j dump.json] session.rec" << endl
+        << "Replays a session recorded by the simulator, without the GUI, and checks the final state" << endl;
+}
+
+int main(int argc, char* args[]) {
+    string path, dump;
+    const Engine* engine = &Engines::get(ENGINE_FASTEST);
+    for(int i = 1; i < argc; i++) {
+        string arg = args[i];
+        if(arg == "-e" && i + 1 < argc) {
+            engine = Engines::find(args[++i]);
+            if(engine == NULL) {
+                usage(args[0]);
+                return 2;
+            }
+        }
+        else if(arg == "-j" && i + 1 < argc) dump = args[++i];
+        else if(arg == "-h" || arg == "--help") {
+            usage(args[0]);
+            return 0;
+        }
+        else if(path == "" && arg[0] != '-') path = arg;
+        else {
+            usage(args[0]);
+            return 2;
+        }
+    }
+    if(path == "") {
+        usage(args[0]);
+        return 2;
+    }
+    vector<SessionEvent> events;
+    if(!Session::read(path, events)) {
+        cerr << "Cannot read " << path << endl;
+        return 1;
+    }
+    if(dump != "") {
+        ofstream file(dump);
+        file << Session::toJson(events);
+        if(!file) {
+            cerr << "Cannot write " << dump << endl;
+            return 1;
+        }
+    }
+    Machine machine;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool identical = Session::replay(events, machine, *engine);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << events.size() << " events replayed with " << engine->name << " in " << seconds << " s, "
+        << machine.CPU.getRetired() << " instructions since the last reload" << endl;
+    string lines[4];
+    machine.IOD.getLines(lines[0], lines[1], lines[2], lines[3]);
+    for(const string& l : lines) cout << "|" << l << endl;
+    if(events.back().type != SESSION_END) {
+        cout << "The session was not ended, the final state cannot be checked" << endl;
+        return 1;
+    }
+    cout << (identical ? "The final state is identical" : "The final state is DIFFERENT") << endl;
+    return identical ? 0 : 1;
+}
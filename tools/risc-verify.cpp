@@ -0,0 +1,266 @@
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "assembler.hpp"
+#include "engine.hpp"
+
+using namespace std;
+
+#define VERIFY_MAX_INSTRUCTIONS 100000000 //A program that does not halt is stopped here
+#define VERIFY_MAX_CELLS 16 //Differing memory cells listed in a report
+#define VERIFY_INTERVAL 10000 //Instructions between two checkpoints of a written hash stream
+#define CHECKPOINTS_MAGIC "risc-checkpoints" //First word of a hash stream file
+#define CHECKPOINTS_VERSION 1
+
+/**
+ * @brief Function to print the usage
+ * @param name The program name
+*/
+static void usage(const char* name) {
+    cout << "Usage: " << name << " [-e engine] [-n max instructions] [-m ram size] [-c interval] source.asm" << endl
+        << "       " << name << " [-e engine] [-n max instructions] [-m ram size] [-c interval] -w hashes.txt source.asm"
+        << endl
+        << "       " << name << " -d hashes.txt other.txt" << endl
+        << "Runs every engine, or only the given one, in lockstep with the reference engine "
+        << Engines::get(0).name << "," << endl
+        << "with -c the state hashes are compared every interval instructions and the lockstep run only covers" << endl
+        << "the first differing interval, -w writes the hash stream of an engine, -d compares two hash streams" << endl;
+}
+
+/**
+ * @brief Function to write a hash stream, one checkpoint per line
+ * @param path The file path
+ * @param interval The instructions between two checkpoints
+ * @param checkpoints The checkpoints
+ * @returns True if written
+*/
+static bool writeCheckpoints(string path, Uint64 interval, const vector<Checkpoint>& checkpoints) {
+    ofstream file(path);
+    file << CHECKPOINTS_MAGIC << " " << CHECKPOINTS_VERSION << " " << interval << endl;
+    for(const Checkpoint& c : checkpoints)
+        file << c.instructions << " " << hex << setw(16) << setfill('0') << c.hash << dec << endl;
+    return bool(file);
+}
+
+/**
+ * @brief Function to read a hash stream
+ * @param path The file path
+ * @param interval Where to store the instructions between two checkpoints
+ * @param checkpoints Where to store the checkpoints
+ * @returns True if read
+*/
+static bool readCheckpoints(string path, Uint64& interval, vector<Checkpoint>& checkpoints) {
+    ifstream file(path);
+    string magic;
+    Uint32 version = 0;
+    file >> magic >> version >> interval;
+    if(!file || magic != CHECKPOINTS_MAGIC || version != CHECKPOINTS_VERSION) return false;
+    Checkpoint c;
+    while(file >> c.instructions >> hex >> c.hash >> dec) checkpoints.push_back(c);
+    return file.eof();
+}
+
+/**
+ * @brief Function to compare two hash streams and print the first interval where they differ
+ * @param first The first file path
+ * @param second The second file path
+ * @returns 0 if they are the same, 1 if they differ, 2 if they cannot be compared
+*/
+static int compareStreams(string first, string second) {
+    Uint64 intervals[2];
+    vector<Checkpoint> a, b;
+    if(!readCheckpoints(first, intervals[0], a) || !readCheckpoints(second, intervals[1], b)) {
+        cerr << "Cannot read the hash streams" << endl;
+        return 2;
+    }
+    if(intervals[0] != intervals[1]) {
+        cerr << "The hash streams have different intervals" << endl;
+        return 2;
+    }
+    size_t index = Engines::firstDifference(a, b);
+    if(index == a.size() && index == b.size()) {
+        cout << a.size() << " checkpoints match" << endl;
+        return 0;
+    }
+    Uint64 from = (index > 0) ? a[index - 1].instructions : 0;
+    Uint64 to = from + intervals[0];
+    cout << "The runs diverge between " << from << " and " << to << " instructions, run the lockstep verification with -n "
+        << to << " to find the instruction" << endl;
+    return 1;
+}
+
+/**
+ * @brief Function to format the status register
+ * @param SR The status register
+ * @returns The flags, type string
+*/
+static string flags(StatusRegister SR) {
+    return string("Z") + char('0' + SR.Z) + " N" + char('0' + SR.N) + " C" + char('0' + SR.C) + " V" + char('0' + SR.V);
+}
+
+/**
+ * @brief Function to compare a field of the two machines and print it if it differs
+ * @param name The field name
+ * @param reference The reference value
+ * @param candidate The candidate value
+ * @returns True if they differ
+*/
+static bool field(string name, string reference, string candidate) {
+    if(reference == candidate) return false;
+    cout << "  " << name << ": " << reference << " != " << candidate << endl;
+    return true;
+}
+
+/**
+ * @brief Function to compare the two machines, only the fields that differ are printed
+ * @param reference The reference machine
+ * @param candidate The candidate machine
+ * @param instructions The instructions retired so far
+ * @param pc The address of the last instruction
+ * @returns True if they are in the same state
+*/
+static bool compare(Machine& reference, Machine& candidate, Uint64 instructions, Uint16 pc) {
+    CentralProcessingUnit& a = reference.CPU;
+    CentralProcessingUnit& b = candidate.CPU;
+    StatusRegister sa = a.getSR(), sb = b.getSR();
+    Uint8 nowA, nextA, nowB, nextB;
+    a.getPhases(nowA, nextA);
+    b.getPhases(nowB, nextB);
+    bool same = a.getPC() == b.getPC() && a.getSP() == b.getSP() && nextA == nextB &&
+        sa.Z == sb.Z && sa.N == sb.N && sa.C == sb.C && sa.V == sb.V &&
+        reference.CM.getHash() == candidate.CM.getHash();
+    for(Uint8 r = 0; same && r < 16; r++) same = a.getR(r) == b.getR(r);
+    string lines[2][4];
+    reference.IOD.getLines(lines[0][0], lines[0][1], lines[0][2], lines[0][3]);
+    candidate.IOD.getLines(lines[1][0], lines[1][1], lines[1][2], lines[1][3]);
+    for(Uint8 l = 0; same && l < 4; l++) same = lines[0][l] == lines[1][l];
+    if(same) return true;
+    cout << "Divergence after " << instructions << " instructions, the last one at " << math::Uint16ToHexstr(pc)
+        << " is " << a.getInstName() << " (reference != candidate)" << endl;
+    field("PC", math::Uint16ToHexstr(a.getPC()), math::Uint16ToHexstr(b.getPC()));
+    field("SP", math::Uint16ToHexstr(a.getSP()), math::Uint16ToHexstr(b.getSP()));
+    for(Uint8 r = 0; r < 16; r++)
+        field(string("R") + "0123456789ABCDEF"[r], math::Uint16ToHexstr(a.getR(r)), math::Uint16ToHexstr(b.getR(r)));
+    field("SR", flags(sa), flags(sb));
+    field("next phase", math::Uint8ToHexstr(nextA), math::Uint8ToHexstr(nextB));
+    for(Uint8 l = 0; l < 4; l++) field("monitor line " + to_string(l), lines[0][l], lines[1][l]);
+    if(reference.CM.getHash() != candidate.CM.getHash()) {
+        //The hashes only say that something differs, the cells are found by scanning
+        Uint32 cells = 0;
+        for(Uint32 address = 0; address < MEMORY_SIZE; address++) {
+            Uint8 x = reference.CM.get(address), y = candidate.CM.get(address);
+            if(x == y) continue;
+            if(cells++ < VERIFY_MAX_CELLS)
+                field("M[" + math::Uint16ToHexstr(address) + "]", math::Uint8ToHexstr(x), math::Uint8ToHexstr(y));
+        }
+        if(cells > VERIFY_MAX_CELLS) cout << "  ... " << cells - VERIFY_MAX_CELLS << " more cells" << endl;
+        if(cells == 0) cout << "  memory hash: cells outside the ram size differ" << endl;
+    }
+    return false;
+}
+
+/**
+ * @brief Function to run a candidate engine in lockstep with the reference, an instruction at a time
+ * @param image The program image
+ * @param ramSize The memory size
+ * @param engine The candidate engine
+ * @param max The maximum number of instructions
+ * @param interval The instructions between two hash comparisons, 0 to run the whole program in lockstep
+ * @returns True if they never diverged
+*/
+static bool verify(const ProgramImage& image, Uint32 ramSize, const Engine& engine, Uint64 max, Uint64 interval) {
+    const Engine& referenceEngine = Engines::get(0);
+    Machine reference, candidate;
+    cout << engine.name << ": ";
+    Uint64 instructions = 0;
+    if(interval > 0) {
+        //Both engines run at full speed, only the first differing interval is run again in lockstep
+        vector<Checkpoint> a, b;
+        reference.load(image, ramSize);
+        candidate.load(image, ramSize);
+        Engines::run(reference, referenceEngine, max, interval, a);
+        Engines::run(candidate, engine, max, interval, b);
+        size_t index = Engines::firstDifference(a, b);
+        if(index == a.size() && index == b.size()) {
+            cout << a.back().instructions << " instructions verified, " << a.size() << " checkpoints"
+                << (a.back().instructions >= max ? ", stopped before HLT" : "") << endl;
+            return true;
+        }
+        instructions = (index > 0) ? a[index - 1].instructions : 0;
+    }
+    reference.load(image, ramSize);
+    candidate.load(image, ramSize);
+    referenceEngine.run(reference.CPU, instructions);
+    engine.run(candidate.CPU, instructions);
+    if(!compare(reference, candidate, instructions, reference.CPU.getPC())) return false;
+    while(instructions < max) {
+        Uint16 pc = reference.CPU.getPC();
+        Uint64 retired = referenceEngine.run(reference.CPU, 1);
+        if(engine.run(candidate.CPU, 1) != retired) {
+            cout << "Divergence after " << instructions << " instructions, at " << math::Uint16ToHexstr(pc)
+                << " only one engine stopped" << endl;
+            return false;
+        }
+        if(retired == 0) break;
+        instructions++;
+        if(!compare(reference, candidate, instructions, pc)) return false;
+    }
+    if(interval > 0) cout << "the hashes differ but the states are the same, it can be a hash collision" << endl;
+    else cout << instructions << " instructions verified" << (instructions >= max ? ", stopped before HLT" : "") << endl;
+    return interval == 0;
+}
+
+int main(int argc, char* args[]) {
+    string source, name, stream;
+    Uint64 max = VERIFY_MAX_INSTRUCTIONS, interval = 0;
+    Uint32 ramSize = MEMORY_SIZE;
+    for(int i = 1; i < argc; i++) {
+        string arg = args[i];
+        if(arg == "-e" && i + 1 < argc) name = args[++i];
+        else if(arg == "-n" && i + 1 < argc) max = strtoull(args[++i], NULL, 0);
+        else if(arg == "-c" && i + 1 < argc) interval = strtoull(args[++i], NULL, 0);
+        else if(arg == "-w" && i + 1 < argc) stream = args[++i];
+        else if(arg == "-d" && i + 2 < argc) return compareStreams(args[i + 1], args[i + 2]);
+        else if(arg == "-m" && i + 1 < argc) ramSize = min(Uint32(strtoul(args[++i], NULL, 0)), Uint32(MEMORY_SIZE));
+        else if(arg == "-h" || arg == "--help") {
+            usage(args[0]);
+            return 0;
+        }
+        else if(source == "" && arg[0] != '-') source = arg;
+        else {
+            usage(args[0]);
+            return 2;
+        }
+    }
+    if(source == "" || (name != "" && Engines::find(name) == NULL)) {
+        usage(args[0]);
+        return 2;
+    }
+    Assembler assembler;
+    ProgramImage image;
+    bool assembled = assembler.assembleFile(source, image);
+    for(const AssemblerDiagnostic& d : assembler.getDiagnostics())
+        cerr << source << ":" << d.line << ": error: " << d.message << endl;
+    if(!assembled) return 1;
+    if(stream != "") {
+        const Engine* engine = (name != "") ? Engines::find(name) : &Engines::get(0);
+        vector<Checkpoint> checkpoints;
+        Machine machine;
+        machine.load(image, ramSize);
+        Engines::run(machine, *engine, max, (interval > 0) ? interval : VERIFY_INTERVAL, checkpoints);
+        if(!writeCheckpoints(stream, (interval > 0) ? interval : VERIFY_INTERVAL, checkpoints)) {
+            cerr << "Cannot write " << stream << endl;
+            return 1;
+        }
+        return 0;
+    }
+    bool verified = true;
+    //The reference is only run against itself when asked for
+    for(Uint8 e = (name != "") ? 0 : 1; e < ENGINES; e++) {
+        if(name != "" && name != Engines::get(e).name) continue;
+        verified = verify(image, ramSize, Engines::get(e), max, interval) && verified;
+    }
+    return verified ? 0 : 1;
+}